@@ -0,0 +1,104 @@
+// bench.h - helpers shared by the benchmark programs in bench/
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Monotonic wall-clock time in seconds
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// A growable byte buffer used to build synthetic A++ sources
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} BenchBuffer;
+
+// Appends 'length' bytes to the buffer
+static inline void bench_append(BenchBuffer *buffer, const char *text, size_t length)
+{
+    if (buffer->length + length + 1 > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (buffer->length + length + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+        buffer->data = realloc(buffer->data, capacity);
+        if (!buffer->data)
+        {
+            fprintf(stderr, "bench: out of memory\n");
+            exit(1);
+        }
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+// Appends printf-formatted text to the buffer
+#define bench_appendf(buffer, ...)                                      \
+    do                                                                  \
+    {                                                                   \
+        char bench_line_[512];                                          \
+        int bench_n_ = snprintf(bench_line_, sizeof(bench_line_), __VA_ARGS__); \
+        bench_append((buffer), bench_line_, (size_t)bench_n_);          \
+    } while (0)
+
+// Starts the executable with 'args' (NULL-terminated), its stdout going to
+// 'out_fd' and its stderr to /dev/null; returns its pid, or -1 if fork failed
+static inline pid_t bench_start_process(char *const args[], int out_fd)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(out_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execv(args[0], args);
+        _exit(127);
+    }
+    if (pid < 0)
+        perror("bench: fork");
+    return pid;
+}
+
+// Runs the executable like bench_start_process() and waits for it; returns false if it failed to start
+static inline bool bench_run_process(char *const args[], int out_fd)
+{
+    pid_t pid = bench_start_process(args, out_fd);
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) != 127;
+}
+
+// Reads a whole file, to compare outputs (empty if it cannot be read)
+static inline BenchBuffer bench_read_file(const char *path)
+{
+    BenchBuffer buffer = {0};
+    char block[65536];
+    size_t got;
+    FILE *file = fopen(path, "rb");
+    while (file != NULL && (got = fread(block, 1, sizeof(block), file)) > 0)
+    {
+        bench_append(&buffer, block, got);
+    }
+    if (file != NULL)
+        fclose(file);
+    return buffer;
+}
+
+#endif // BENCH_H
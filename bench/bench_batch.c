@@ -0,0 +1,145 @@
+// bench_batch.c - scripts per second: one process per script against --batch
+//
+// Writes many small scripts (2000 by default, or the count given as the
+// second argument) to a temporary directory, then runs them through the a++c
+// executable (the first argument, default ./build/bin/a++c):
+//   - one a++c process per script, one after the other;
+//   - one `a++c --batch` process with 1, 2, 4, ... threads, up to the number
+//     of CPUs, reading the scripts from a manifest.
+// The batch output is compared with the per-process output first, so a
+// faster run that prints something else is reported as an error.
+#include "bench.h"
+
+#define DEFAULT_SCRIPT_COUNT 2000
+
+// This function writes one small script; the seed varies its values and length
+static bool write_script(const char *path, int seed)
+{
+    BenchBuffer buffer = {0};
+    int lines = 10 + seed % 30;
+    bench_appendf(&buffer, "int total = %d;\n", seed);
+    bench_appendf(&buffer, "string name = \"script %d\";\n", seed);
+    for (int i = 0; i < lines; i++)
+    {
+        bench_appendf(&buffer, "int v%d = (total * %d + %d) %% 9973;\n", i, i + 3, seed);
+        bench_appendf(&buffer, "total = total + v%d ** 2 / (%d + 1);\n", i, i);
+    }
+    bench_appendf(&buffer, "bool odd = %s;\nprint(name);\nprint(total);\nprint(odd);\n", seed % 2 ? "true" : "false");
+
+    FILE *file = fopen(path, "w");
+    bool ok = file != NULL && fwrite(buffer.data, 1, buffer.length, file) == buffer.length;
+    if (file != NULL)
+        ok = fclose(file) == 0 && ok;
+    free(buffer.data);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    char *program = argc > 1 ? argv[1] : "./build/bin/a++c";
+    int count = argc > 2 ? atoi(argv[2]) : DEFAULT_SCRIPT_COUNT;
+    if (access(program, X_OK) != 0 || count < 1)
+    {
+        printf("Usage: bench_batch [path to a++c] [script count]   (build a++c with 'make' first)\n");
+        return 1;
+    }
+
+    char dir[] = "/tmp/a++-bench-batch-XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("bench: mkdtemp");
+        return 1;
+    }
+
+    // The scripts, and a manifest listing them in order
+    char manifest[sizeof(dir) + 32];
+    snprintf(manifest, sizeof(manifest), "%s/manifest", dir);
+    FILE *list = fopen(manifest, "w");
+    char (*paths)[sizeof(dir) + 32] = malloc((size_t)count * sizeof(*paths));
+    if (list == NULL || paths == NULL)
+    {
+        perror("bench: manifest");
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "%s/s%05d.a++", dir, i);
+        if (!write_script(paths[i], i))
+        {
+            perror("bench: script");
+            return 1;
+        }
+        fprintf(list, "%s\n", paths[i]);
+    }
+    fclose(list);
+
+    char expected_path[sizeof(dir) + 32];
+    char actual_path[sizeof(dir) + 32];
+    snprintf(expected_path, sizeof(expected_path), "%s/expected.out", dir);
+    snprintf(actual_path, sizeof(actual_path), "%s/actual.out", dir);
+
+    // One process per script, writing what --batch is expected to print
+    int expected_fd = open(expected_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    double start = bench_now();
+    for (int i = 0; i < count; i++)
+    {
+        char header[sizeof(paths[i]) + 16];
+        int length = snprintf(header, sizeof(header), "==> %s <==\n", paths[i]);
+        if (write(expected_fd, header, (size_t)length) != length)
+        {
+            perror("bench: write");
+            return 1;
+        }
+        char *args[] = {program, paths[i], NULL};
+        if (!bench_run_process(args, expected_fd))
+            return 1;
+    }
+    double process_seconds = bench_now() - start;
+    close(expected_fd);
+    BenchBuffer expected = bench_read_file(expected_path);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d scripts, %ld CPUs\n", count, cpus);
+    printf("%-22s %12s %10s\n", "mode", "scripts/s", "speedup");
+    printf("%-22s %12.0f %9.1fx\n", "process per script", count / process_seconds, 1.0);
+
+    char manifest_option[sizeof(manifest) + 16];
+    snprintf(manifest_option, sizeof(manifest_option), "--manifest=%s", manifest);
+    int status = 0;
+    for (long jobs = 1; jobs <= (cpus > 0 ? cpus : 1) && status == 0; jobs *= 2)
+    {
+        char jobs_option[32];
+        snprintf(jobs_option, sizeof(jobs_option), "--jobs=%ld", jobs);
+        char *args[] = {program, manifest_option, jobs_option, NULL};
+
+        int actual_fd = open(actual_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        start = bench_now();
+        bool ran = bench_run_process(args, actual_fd);
+        double seconds = bench_now() - start;
+        close(actual_fd);
+
+        BenchBuffer actual = bench_read_file(actual_path);
+        if (!ran || actual.length != expected.length || memcmp(actual.data, expected.data, expected.length) != 0)
+        {
+            printf("Error: --batch %s printed something other than one process per script.\n", jobs_option);
+            status = 1;
+        }
+        else
+        {
+            char label[64];
+            snprintf(label, sizeof(label), "--batch, %ld thread%s", jobs, jobs == 1 ? "" : "s");
+            printf("%-22s %12.0f %9.1fx\n", label, count / seconds, process_seconds / seconds);
+        }
+        free(actual.data);
+    }
+
+    for (int i = 0; i < count; i++)
+        unlink(paths[i]);
+    unlink(manifest);
+    unlink(expected_path);
+    unlink(actual_path);
+    rmdir(dir);
+    free(paths);
+    free(expected.data);
+    return status;
+}
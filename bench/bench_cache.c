@@ -0,0 +1,211 @@
+// bench_cache.c - startup latency with and without the precompiled program cache
+//
+// Writes scripts of 4 KB up to 8 MB (declarations and nested arithmetic, with
+// one print at the end so running them costs little), then measures:
+//   - in process: building the checked AST (lex, parse, resolve, type check,
+//     optimize) against loading the same program with cache_load();
+//   - end to end: running the a++c executable on the script without the cache
+//     (cold) and with a cache directory it has already filled (cached).
+// The executable is taken from the first argument (default ./build/bin/a++c);
+// if it is missing, only the in-process numbers are printed. Every time is the
+// fastest of several runs.
+#include "bench.h"
+#include "cache/cache.h"
+#include "optimizer/optimizer.h"
+#include "parser/parser.h"
+#include "semantic/resolver.h"
+#include "semantic/typecheck.h"
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const size_t script_sizes[] = {4 << 10, 64 << 10, 1 << 20, 8 << 20};
+#define SIZE_COUNT (sizeof(script_sizes) / sizeof(script_sizes[0]))
+
+// This function builds a script of at least 'size' bytes whose statements depend on each other
+static BenchBuffer make_script(size_t size)
+{
+    BenchBuffer buffer = {0};
+    bench_append(&buffer, "int total_0 = 1;\n", 17);
+    int i = 1;
+    for (; buffer.length < size; i++)
+    {
+        bench_appendf(&buffer, "int total_%d = ((total_%d * 31 + %d) %% 1000003 - 17) * 2 + 1;\n", i, i - 1, i);
+        bench_appendf(&buffer, "string label_%d = \"entry %d\";\n", i, i);
+        bench_appendf(&buffer, "bool seen_%d = %s;\n", i, i % 2 ? "true" : "false");
+    }
+    bench_appendf(&buffer, "print(total_%d);\n", i - 1);
+    return buffer;
+}
+
+// This function runs the front end and the optimizer, as the driver does on a cache miss
+static ASTNode *build(const BenchBuffer *script, Arena *arena, size_t *slot_count)
+{
+    Lexer *lexer = init_lexer_n(script->data, script->length);
+    Parser *parser = create_parser(lexer, arena);
+    ASTNode *ast = parse_tokens(parser);
+    SymbolTable *symbols = create_symbol_table();
+    bool ok = ast != NULL && resolve_program(symbols, ast) && typecheck_program(ast, symbols->slot_count) &&
+              optimize_program(ast, OPT_LEVEL_DEFAULT);
+    *slot_count = symbols->slot_count;
+    free_symbol_table(symbols);
+    free_parser(parser);
+    free(lexer);
+    return ok ? ast : NULL;
+}
+
+// This function runs the executable once with its output discarded and returns the wall time, or -1
+static double time_process(const char *program, const char *cache_option, const char *script_path)
+{
+    double start = bench_now();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("bench: fork");
+        return -1;
+    }
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        if (cache_option != NULL)
+            execl(program, program, cache_option, script_path, (char *)NULL);
+        else
+            execl(program, program, script_path, (char *)NULL);
+        _exit(127);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    double seconds = bench_now() - start;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? seconds : -1;
+}
+
+// This function keeps the fastest of 'runs' process runs, or returns -1 if any run failed
+static double best_process_time(const char *program, const char *cache_option, const char *script_path, int runs)
+{
+    double best = -1;
+    for (int run = 0; run < runs; run++)
+    {
+        double seconds = time_process(program, cache_option, script_path);
+        if (seconds < 0)
+            return -1;
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *program = argc > 1 ? argv[1] : "./build/bin/a++c";
+    bool have_program = access(program, X_OK) == 0;
+    if (!have_program)
+        printf("(%s not found: build it with 'make' for the end-to-end numbers)\n", program);
+
+    char dir[] = "/tmp/a++-bench-cache-XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("bench: mkdtemp");
+        return 1;
+    }
+    char script_path[sizeof(dir) + 32];
+    snprintf(script_path, sizeof(script_path), "%s/script.a++", dir);
+    char cache_option[sizeof(dir) + 32];
+    snprintf(cache_option, sizeof(cache_option), "--cache-dir=%s/ast", dir);
+    const char *cache_dir = cache_option + strlen("--cache-dir=");
+
+    printf("%-10s %10s %10s %10s %12s %12s %8s\n", "script", "build ms", "load ms", "speedup", "cold ms",
+           "cached ms", "speedup");
+
+    int status = 0;
+    for (size_t s = 0; s < SIZE_COUNT && status == 0; s++)
+    {
+        BenchBuffer script = make_script(script_sizes[s]);
+        int runs = script_sizes[s] >= (1 << 20) ? 5 : 20;
+
+        // In process: the front end against a cache load of the same program
+        double build_time = -1;
+        double load_time = -1;
+        uint64_t key = cache_key(script.data, script.length, OPT_LEVEL_DEFAULT);
+        for (int run = 0; run < runs; run++)
+        {
+            Arena *arena = create_arena(0);
+            size_t slot_count;
+            double start = bench_now();
+            ASTNode *ast = build(&script, arena, &slot_count);
+            double seconds = bench_now() - start;
+            if (ast == NULL || (run == 0 && !cache_store(cache_dir, key, ast, slot_count)))
+            {
+                printf("Error: Could not build and cache the %zu-byte script.\n", script.length);
+                free_arena(arena);
+                status = 1;
+                break;
+            }
+            free_arena(arena);
+            if (build_time < 0 || seconds < build_time)
+                build_time = seconds;
+
+            arena = create_arena(0);
+            CachedProgram cached;
+            start = bench_now();
+            bool hit = cache_load(cache_dir, key, arena, &cached);
+            seconds = bench_now() - start;
+            if (!hit)
+            {
+                printf("Error: The cached %zu-byte script could not be loaded.\n", script.length);
+                free_arena(arena);
+                status = 1;
+                break;
+            }
+            release_cached_program(&cached);
+            free_arena(arena);
+            if (load_time < 0 || seconds < load_time)
+                load_time = seconds;
+        }
+        if (status != 0)
+        {
+            free(script.data);
+            break;
+        }
+
+        // End to end: the driver's whole startup, including process creation
+        double cold_time = -1;
+        double cached_time = -1;
+        if (have_program)
+        {
+            FILE *file = fopen(script_path, "w");
+            bool written = file != NULL && fwrite(script.data, 1, script.length, file) == script.length;
+            if (file != NULL)
+                written = fclose(file) == 0 && written;
+            if (written)
+            {
+                cold_time = best_process_time(program, NULL, script_path, runs);
+                // The first cached run fills the cache (the key is the same as above)
+                if (time_process(program, cache_option, script_path) >= 0)
+                    cached_time = best_process_time(program, cache_option, script_path, runs);
+            }
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "%zu KB", script.length >> 10);
+        printf("%-10s %10.3f %10.3f %9.1fx", label, build_time * 1e3, load_time * 1e3, build_time / load_time);
+        if (cold_time >= 0 && cached_time >= 0)
+            printf(" %12.3f %12.3f %7.1fx\n", cold_time * 1e3, cached_time * 1e3, cold_time / cached_time);
+        else
+            printf(" %12s %12s %8s\n", "-", "-", "-");
+
+        char cache_path[sizeof(dir) + 64];
+        snprintf(cache_path, sizeof(cache_path), "%s/%016llx.astc", cache_dir, (unsigned long long)key);
+        unlink(cache_path);
+        free(script.data);
+    }
+
+    unlink(script_path);
+    char ast_dir[sizeof(dir) + 8];
+    snprintf(ast_dir, sizeof(ast_dir), "%s/ast", dir);
+    rmdir(ast_dir);
+    rmdir(dir);
+    return status;
+}
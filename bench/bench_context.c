@@ -0,0 +1,229 @@
+// bench_context.c - running one program many times, and on several threads
+//
+// Builds a script of about 64 KB (declarations, arithmetic, string and bool
+// variables and prints) and, for each engine, measures runs per second:
+//   - rebuild: build the program and its context for every run, as separate
+//     a++c invocations would (minus process startup);
+//   - reuse: build once, then run one context over and over;
+//   - N threads: one shared program, one context per thread, all running at
+//     once.
+// Before timing, every thread's output is compared with a single-threaded
+// run, so interference between contexts shows up as an error, not a number.
+#include "bench.h"
+#include "core/core.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define SCRIPT_SIZE (64 << 10)
+#define MAX_THREADS 8
+#define CHECK_THREADS 4 // Even on one CPU, so the threads interleave (at most MAX_THREADS)
+#define MIN_SECONDS 0.5
+
+static const char *const engine_names[] = {"vm", "tree", "jit"};
+
+// The work given to one thread
+typedef struct
+{
+    const Program *program;
+    ExecutionEngine engine;
+    int fd;     // Where the output goes
+    int runs;   // How many times to run the program
+    bool ok;
+} Job;
+
+// This function builds a script of at least 'size' bytes that exercises every kind of statement
+static BenchBuffer make_script(size_t size)
+{
+    BenchBuffer buffer = {0};
+    bench_append(&buffer, "int acc_0 = 1;\n", 15);
+    for (int i = 1; buffer.length < size; i++)
+    {
+        bench_appendf(&buffer, "int acc_%d = (acc_%d * 7 + %d) %% 10007;\n", i, i - 1, i);
+        bench_appendf(&buffer, "string tag_%d = \"tag %d\";\n", i, i);
+        bench_appendf(&buffer, "bool odd_%d = %s;\n", i, i % 2 ? "true" : "false");
+        bench_appendf(&buffer, "acc_%d = acc_%d ** 2 %% 10007 - acc_%d / 3;\n", i, i, i - 1);
+        if (i % 4 == 0)
+        {
+            bench_appendf(&buffer, "print(acc_%d);\n", i);
+            bench_appendf(&buffer, "print(tag_%d);\n", i);
+            bench_appendf(&buffer, "print(odd_%d);\n", i);
+        }
+    }
+    return buffer;
+}
+
+// This function runs a job on its own context; it is the body of every thread
+static void *run_job(void *argument)
+{
+    Job *job = (Job *)argument;
+    Context *context = create_context(job->program, job->engine);
+    Output *out = create_output(job->fd);
+    job->ok = context != NULL && out != NULL;
+    for (int run = 0; run < job->runs && job->ok; run++)
+    {
+        job->ok = run_context(context, out);
+    }
+    free_output(out);
+    free_context(context);
+    return NULL;
+}
+
+// This function runs 'threads' jobs at once and returns the wall time, or -1 if one failed
+static double run_jobs(Job *jobs, int threads)
+{
+    pthread_t ids[MAX_THREADS];
+    double start = bench_now();
+    for (int t = 0; t < threads; t++)
+    {
+        if (pthread_create(&ids[t], NULL, run_job, &jobs[t]) != 0)
+        {
+            perror("bench: pthread_create");
+            exit(1);
+        }
+    }
+    bool ok = true;
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(ids[t], NULL);
+        ok = ok && jobs[t].ok;
+    }
+    return ok ? bench_now() - start : -1;
+}
+
+// This function reads a whole temporary file back
+static BenchBuffer read_back(int fd)
+{
+    BenchBuffer buffer = {0};
+    char block[65536];
+    ssize_t got;
+    lseek(fd, 0, SEEK_SET);
+    while ((got = read(fd, block, sizeof(block))) > 0)
+    {
+        bench_append(&buffer, block, (size_t)got);
+    }
+    return buffer;
+}
+
+// This function checks that every thread prints exactly what a single run prints
+static bool check_threads(const Program *program, ExecutionEngine engine)
+{
+    int threads = CHECK_THREADS;
+    Job jobs[CHECK_THREADS + 1];
+    FILE *files[CHECK_THREADS + 1];
+    for (int t = 0; t <= threads; t++)
+    {
+        files[t] = tmpfile();
+        if (files[t] == NULL)
+        {
+            perror("bench: tmpfile");
+            exit(1);
+        }
+        jobs[t] = (Job){program, engine, fileno(files[t]), 3, false};
+    }
+
+    // Job 0 runs alone and is the reference; the others run together
+    bool ok = run_jobs(jobs, 1) >= 0 && run_jobs(jobs + 1, threads) >= 0;
+    BenchBuffer expected = read_back(jobs[0].fd);
+    for (int t = 1; t <= threads && ok; t++)
+    {
+        BenchBuffer actual = read_back(jobs[t].fd);
+        ok = actual.length == expected.length && memcmp(actual.data, expected.data, expected.length) == 0;
+        free(actual.data);
+    }
+    free(expected.data);
+    for (int t = 0; t <= threads; t++)
+    {
+        fclose(files[t]);
+    }
+    return ok;
+}
+
+// This function times 'threads' threads running the program until MIN_SECONDS have passed, in runs per second
+static double threaded_rate(const Program *program, ExecutionEngine engine, int threads, int null_fd)
+{
+    Job jobs[MAX_THREADS];
+    for (int runs = 4;; runs *= 2)
+    {
+        for (int t = 0; t < threads; t++)
+        {
+            jobs[t] = (Job){program, engine, null_fd, runs, false};
+        }
+        double seconds = run_jobs(jobs, threads);
+        if (seconds < 0)
+            return -1;
+        if (seconds >= MIN_SECONDS)
+            return (double)runs * threads / seconds;
+    }
+}
+
+// This function times building, compiling and running the program from scratch every time, in runs per second
+static double rebuild_rate(const BenchBuffer *script, ExecutionEngine engine, int null_fd)
+{
+    BuildOptions options = {OPT_LEVEL_DEFAULT, NULL};
+    Output *out = create_output(null_fd);
+    int runs = 0;
+    double start = bench_now();
+    double seconds;
+    do
+    {
+        Program *program = build_program(script->data, script->length, &options);
+        Context *context = program ? create_context(program, engine) : NULL;
+        bool ok = context != NULL && run_context(context, out);
+        free_context(context);
+        free_program(program);
+        if (!ok)
+        {
+            free_output(out);
+            return -1;
+        }
+        runs++;
+        seconds = bench_now() - start;
+    } while (seconds < MIN_SECONDS);
+    free_output(out);
+    return runs / seconds;
+}
+
+int main(void)
+{
+    BenchBuffer script = make_script(SCRIPT_SIZE);
+    BuildOptions options = {OPT_LEVEL_DEFAULT, NULL};
+    Program *program = build_program(script.data, script.length, &options);
+    if (program == NULL)
+    {
+        printf("Error: The benchmark script does not build.\n");
+        return 1;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = cpus < 1 ? 1 : cpus > MAX_THREADS ? MAX_THREADS : (int)cpus;
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    printf("%zu KB script, runs per second (%d CPUs)\n", script.length >> 10, (int)cpus);
+    printf("%-6s %10s %10s", "engine", "rebuild", "reuse");
+    for (int threads = 2; threads <= max_threads; threads *= 2)
+        printf(" %7d thr", threads);
+    printf("\n");
+
+    int status = 0;
+    for (ExecutionEngine engine = ENGINE_VM; engine <= ENGINE_JIT; engine++)
+    {
+        if (!check_threads(program, engine))
+        {
+            printf("Error: Threads running on %s printed different output.\n", engine_names[engine]);
+            status = 1;
+            continue;
+        }
+
+        printf("%-6s %10.0f %10.0f", engine_names[engine], rebuild_rate(&script, engine, null_fd),
+               threaded_rate(program, engine, 1, null_fd));
+        for (int threads = 2; threads <= max_threads; threads *= 2)
+            printf(" %11.0f", threaded_rate(program, engine, threads, null_fd));
+        printf("\n");
+    }
+
+    close(null_fd);
+    free_program(program);
+    free(script.data);
+    return status;
+}
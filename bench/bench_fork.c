@@ -0,0 +1,141 @@
+// bench_fork.c - jobs per second: a cold a++c process per job against --fork-jobs
+//
+// Writes a small and a medium script that each take an `int seed;` parameter,
+// and a jobs file giving each of many jobs (500 by default, or the count given
+// as the second argument) its own seed. Then runs the jobs through the a++c
+// executable (the first argument, default ./build/bin/a++c):
+//   - one `a++c --param=seed=<n> script` process per job, each building the program;
+//   - one `a++c --fork-jobs` process with 1, 2, 4, ... children at once, up to the
+//     number of CPUs, building the program once and forking a child per job.
+// The --fork-jobs output is compared with the per-process output first.
+#include "bench.h"
+
+#define DEFAULT_JOB_COUNT 500
+
+// This function writes a script of about 'lines' statements, driven by its 'seed' parameter
+static bool write_script(const char *path, int lines)
+{
+    BenchBuffer buffer = {0};
+    bench_appendf(&buffer, "int seed;\nint total = seed;\nstring name = \"%d lines\";\n", lines);
+    for (int i = 0; i < lines / 2; i++)
+    {
+        bench_appendf(&buffer, "int v%d = (total * %d + seed) %% 9973;\n", i, i + 3);
+        bench_appendf(&buffer, "total = total + v%d ** 2 / (%d + 1);\n", i, i);
+    }
+    bench_appendf(&buffer, "print(name);\nprint(total);\n");
+
+    FILE *file = fopen(path, "w");
+    bool ok = file != NULL && fwrite(buffer.data, 1, buffer.length, file) == buffer.length;
+    if (file != NULL)
+        ok = fclose(file) == 0 && ok;
+    free(buffer.data);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    char *program = argc > 1 ? argv[1] : "./build/bin/a++c";
+    int count = argc > 2 ? atoi(argv[2]) : DEFAULT_JOB_COUNT;
+    if (access(program, X_OK) != 0 || count < 1)
+    {
+        printf("Usage: bench_fork [path to a++c] [job count]   (build a++c with 'make' first)\n");
+        return 1;
+    }
+
+    char dir[] = "/tmp/a++-bench-fork-XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("bench: mkdtemp");
+        return 1;
+    }
+    char small_path[sizeof(dir) + 32];
+    char medium_path[sizeof(dir) + 32];
+    char jobs_path[sizeof(dir) + 32];
+    char expected_path[sizeof(dir) + 32];
+    char actual_path[sizeof(dir) + 32];
+    snprintf(small_path, sizeof(small_path), "%s/small.a++", dir);
+    snprintf(medium_path, sizeof(medium_path), "%s/medium.a++", dir);
+    snprintf(jobs_path, sizeof(jobs_path), "%s/jobs", dir);
+    snprintf(expected_path, sizeof(expected_path), "%s/expected.out", dir);
+    snprintf(actual_path, sizeof(actual_path), "%s/actual.out", dir);
+    FILE *jobs = fopen(jobs_path, "w");
+    if (!write_script(small_path, 20) || !write_script(medium_path, 4000) || jobs == NULL)
+    {
+        perror("bench: script");
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(jobs, "seed=%d\n", i * 7919 % 100003);
+    }
+    fclose(jobs);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d jobs, %ld CPUs\n", count, cpus);
+    printf("%-8s %-22s %12s %10s\n", "script", "mode", "jobs/s", "speedup");
+    char jobs_option[sizeof(jobs_path) + 16];
+    snprintf(jobs_option, sizeof(jobs_option), "--fork-jobs=%s", jobs_path);
+    const char *names[] = {"small", "medium"};
+    char *paths[] = {small_path, medium_path};
+    int status = 0;
+    for (int s = 0; s < 2 && status == 0; s++)
+    {
+        // One process per job, writing what --fork-jobs is expected to print
+        int expected_fd = open(expected_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        double start = bench_now();
+        for (int i = 0; i < count && status == 0; i++)
+        {
+            int seed = i * 7919 % 100003;
+            char header[64];
+            char param[64];
+            int length = snprintf(header, sizeof(header), "==> seed=%d <==\n", seed);
+            snprintf(param, sizeof(param), "--param=seed=%d", seed);
+            char *args[] = {program, param, paths[s], NULL};
+            if (write(expected_fd, header, (size_t)length) != length || !bench_run_process(args, expected_fd))
+            {
+                perror("bench: cold run");
+                status = 1;
+            }
+        }
+        double process_seconds = bench_now() - start;
+        close(expected_fd);
+        BenchBuffer expected = bench_read_file(expected_path);
+        printf("%-8s %-22s %12.0f %9.1fx\n", names[s], "process per job", count / process_seconds, 1.0);
+
+        for (long children = 1; children <= (cpus > 0 ? cpus : 1) && status == 0; children *= 2)
+        {
+            char children_option[32];
+            snprintf(children_option, sizeof(children_option), "--jobs=%ld", children);
+            char *args[] = {program, jobs_option, children_option, paths[s], NULL};
+
+            int actual_fd = open(actual_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            start = bench_now();
+            bool ran = bench_run_process(args, actual_fd);
+            double seconds = bench_now() - start;
+            close(actual_fd);
+
+            BenchBuffer actual = bench_read_file(actual_path);
+            if (!ran || actual.length != expected.length || memcmp(actual.data, expected.data, expected.length) != 0)
+            {
+                printf("Error: --fork-jobs %s printed something other than one process per job.\n", children_option);
+                status = 1;
+            }
+            else
+            {
+                char label[64];
+                snprintf(label, sizeof(label), "--fork-jobs, %ld child%s", children, children == 1 ? "" : "ren");
+                printf("%-8s %-22s %12.0f %9.1fx\n", names[s], label, count / seconds, process_seconds / seconds);
+            }
+            free(actual.data);
+        }
+        free(expected.data);
+    }
+
+    unlink(small_path);
+    unlink(medium_path);
+    unlink(jobs_path);
+    unlink(expected_path);
+    unlink(actual_path);
+    rmdir(dir);
+    return status;
+}
@@ -0,0 +1,113 @@
+// bench_jit.c - tree-walking interpreter against the JIT on integer workloads
+//
+// Parses a synthetic program of integer declarations and assignments once,
+// then times repeated executions with each engine. "jit" includes compiling
+// the native code on every run, as --engine=jit does; "jit (compiled once)"
+// reuses the code, which is what a long-running host would do. The bytecode
+// VM is included for reference.
+#include "bench.h"
+#include "interpreter/interpreter.h"
+#include "jit/jit.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "semantic/resolver.h"
+#include "semantic/typecheck.h"
+#include "vm/compiler.h"
+#include "vm/vm.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+#define STATEMENT_COUNT 5000
+
+// This function builds a program of integer arithmetic; 'divide' mixes in division and modulus
+static BenchBuffer make_source(bool divide)
+{
+    BenchBuffer buffer = {0};
+    bench_appendf(&buffer, "int v0 = 1;\nint v1 = 2;\n");
+    for (int i = 2; i < STATEMENT_COUNT; i++)
+    {
+        if (divide)
+            bench_appendf(&buffer, "int v%d = (v%d * 7 + v%d / 3) %% 10007 - %d;\n", i, i - 1, i - 2, i);
+        else
+            bench_appendf(&buffer, "int v%d = (v%d * 7 + v%d * 3) - (v%d - %d) * 2;\n", i, i - 1, i - 2, i - 1, i);
+        if (i % 10 == 0)
+            bench_appendf(&buffer, "v%d = v%d + v%d * v%d;\n", i - 5, i, i - 1, i - 2);
+    }
+    bench_appendf(&buffer, "print(v%d);\n", STATEMENT_COUNT - 1);
+    return buffer;
+}
+
+static void run_workload(const char *name, bool divide, int repeats)
+{
+    BenchBuffer source = make_source(divide);
+    Lexer *lexer = init_lexer_n(source.data, source.length);
+    Arena *arena = create_arena(0);
+    Parser *parser = create_parser(lexer, arena);
+    ASTNode *ast = parse_tokens(parser);
+    SymbolTable *symbols = create_symbol_table();
+    if (ast == NULL || !resolve_program(symbols, ast) || !typecheck_program(ast, symbols->slot_count))
+    {
+        fprintf(stderr, "bench: failed to build the %s workload\n", name);
+        exit(1);
+    }
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    Output *out = create_output(null_fd);
+
+    double start = bench_now();
+    for (int r = 0; r < repeats; r++)
+        interpret(ast, symbols->slot_count, out, false);
+    double tree = (bench_now() - start) / repeats;
+
+    start = bench_now();
+    for (int r = 0; r < repeats; r++)
+        interpret(ast, symbols->slot_count, out, true);
+    double jit = (bench_now() - start) / repeats;
+
+    // The precompiled case keeps its variables in a plain int array
+    JitSlotLayout layout = {sizeof(int), 0};
+    JitProgram *program = jit_compile_program(ast, &layout);
+    int *slots = calloc(symbols->slot_count, sizeof(int));
+    double jit_once = 0;
+    if (program)
+    {
+        start = bench_now();
+        for (int r = 0; r < repeats; r++)
+            for (size_t s = 0; s < program->segment_count; s++)
+                jit_run_segment(&program->segments[s], slots, out);
+        jit_once = (bench_now() - start) / repeats;
+    }
+
+    Chunk *chunk = compile_to_bytecode(ast, symbols->slot_count);
+    start = bench_now();
+    for (int r = 0; r < repeats; r++)
+        run_bytecode(chunk, out);
+    double vm = (bench_now() - start) / repeats;
+
+    printf("%-14s %12.1f %12.1f %14.1f %12.1f %9.2fx\n", name, tree * 1e6, jit * 1e6, jit_once * 1e6, vm * 1e6,
+           jit_once > 0 ? tree / jit_once : 0.0);
+
+    free_chunk(chunk);
+    free(slots);
+    free_jit_program(program);
+    free_output(out);
+    close(null_fd);
+    free_symbol_table(symbols);
+    free_parser(parser);
+    free_arena(arena);
+    free(lexer);
+    free(source.data);
+}
+
+int main(int argc, char *argv[])
+{
+    int repeats = argc > 1 ? atoi(argv[1]) : 200;
+    if (!jit_available())
+    {
+        printf("note: no JIT on this platform, so the jit column measures the interpreter fallback\n");
+    }
+    printf("%-14s %12s %12s %14s %12s %10s\n", "workload (us)", "tree", "jit", "jit (once)", "vm", "tree/jit");
+    run_workload("add/sub/mul", false, repeats);
+    run_workload("with div/mod", true, repeats);
+    return 0;
+}
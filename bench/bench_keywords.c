@@ -0,0 +1,95 @@
+// bench_keywords.c - keyword classification cost per identifier
+//
+// Classifies every reserved word, plus identifiers that look like keywords,
+// with lookup_keyword() and with a chain of comparisons over the same words
+// (the approach the lexer used before, extended to every keyword). The
+// chain's cost depends on how far down the list a word is; lookup_keyword()
+// should cost the same for every word. Finally the whole lexer is timed on
+// identifier-heavy input.
+#include "bench.h"
+#include "lexer/lexer.h"
+
+#define ROUNDS 2000000
+
+// Every reserved word, in the order a comparison chain would test them
+static const char *const spellings[] = {
+    "int",   "string", "print", "echo",   "bool",     "true",  "false",  "if",
+    "else",  "elseif", "break", "continue", "void",   "return", "const", "char",
+    "short", "long",   "unsigned", "signed", "double", "float",
+};
+#define SPELLING_COUNT (sizeof(spellings) / sizeof(spellings[0]))
+
+// Identifiers that share a length, prefix or last letter with keywords
+static const char *const near_misses[] = {"x", "in", "prints", "strinq", "counter", "unsigner"};
+#define NEAR_MISS_COUNT (sizeof(near_misses) / sizeof(near_misses[0]))
+
+// Keeps the compiler from discarding results it can see are unused
+static volatile size_t sink;
+
+// This function is the comparison chain: every keyword is tried in turn
+static int chain_lookup(const char *text, size_t length)
+{
+    for (size_t i = 0; i < SPELLING_COUNT; i++)
+    {
+        if (strlen(spellings[i]) == length && memcmp(text, spellings[i], length) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+// This function times both lookups on one word, in nanoseconds per call
+static void time_word(const char *word)
+{
+    // Copy the word so the compiler cannot fold the lookups at compile time
+    char text[32];
+    size_t length = strlen(word);
+    memcpy(text, word, length + 1);
+    volatile size_t volatile_length = length;
+
+    double start = bench_now();
+    for (int r = 0; r < ROUNDS; r++)
+        sink += (size_t)lookup_keyword(text, volatile_length);
+    double table = (bench_now() - start) / ROUNDS;
+
+    start = bench_now();
+    for (int r = 0; r < ROUNDS; r++)
+        sink += (size_t)chain_lookup(text, volatile_length);
+    double chain = (bench_now() - start) / ROUNDS;
+
+    printf("%-10s %10.2f %10.2f\n", word, table * 1e9, chain * 1e9);
+}
+
+// This function lexes an identifier-heavy source and reports the time per token
+static void time_lexer(void)
+{
+    BenchBuffer source = {0};
+    for (int i = 0; source.length < 16 * 1024 * 1024; i++)
+    {
+        bench_appendf(&source, "%s counter_%d unsigned value %s x%d elseif strinq\n", spellings[i % SPELLING_COUNT], i,
+                      spellings[(i * 7) % SPELLING_COUNT], i);
+    }
+
+    Lexer *lexer = init_lexer_n(source.data, source.length);
+    size_t tokens = 0;
+    double start = bench_now();
+    while (next_token(lexer).type != TOKEN_EOF)
+    {
+        tokens++;
+    }
+    double elapsed = bench_now() - start;
+    printf("\nlexer: %zu tokens in %.3f s, %.2f ns/token, %.1f MB/s\n", tokens, elapsed, elapsed * 1e9 / tokens,
+           source.length / elapsed / (1024.0 * 1024.0));
+    free(lexer);
+    free(source.data);
+}
+
+int main(void)
+{
+    printf("%-10s %10s %10s\n", "word", "table ns", "chain ns");
+    for (size_t i = 0; i < SPELLING_COUNT; i++)
+        time_word(spellings[i]);
+    for (size_t i = 0; i < NEAR_MISS_COUNT; i++)
+        time_word(near_misses[i]);
+    time_lexer();
+    return 0;
+}
@@ -0,0 +1,101 @@
+// bench_lexer.c - lexing throughput across input sizes
+//
+// Tokenizes synthetic sources from 1 KB up to 100 MB (or the size given in
+// MB as the first argument), growing tenfold each step, and reports the
+// throughput of every scanning level the CPU supports (scalar, SSE2, AVX2).
+// Lexing is linear when the ns/byte column stays flat as the input grows.
+// The "typical" source has short tokens; the "generated" one has the long
+// indentation, names, comments and strings of machine-written code, where
+// vector scanning has whole blocks to skip.
+#include "bench.h"
+#include "lexer/lexer.h"
+#include "lexer/scan.h"
+
+// This function builds a source of at least 'size' bytes out of typical or generated statements
+static BenchBuffer make_source(size_t size, bool generated)
+{
+    BenchBuffer buffer = {0};
+    for (int i = 0; buffer.length < size; i++)
+    {
+        if (generated)
+        {
+            bench_appendf(&buffer, "                // Accumulator for stage %d of the generated pipeline; do not edit by hand\n", i);
+            bench_appendf(&buffer, "                int generated_pipeline_stage_accumulator_%d = generated_pipeline_stage_accumulator_%d + 1;\n",
+                          i, i > 0 ? i - 1 : 0);
+            bench_appendf(&buffer, "                string generated_pipeline_stage_label_%d = \"stage %d of the generated pipeline, see the "
+                                   "specification for details\";\n", i, i);
+            continue;
+        }
+        bench_appendf(&buffer, "int value_%d = %d * (value_%d + 17) ** 2 %% 1000; // update\n", i, i, i > 0 ? i - 1 : 0);
+        bench_appendf(&buffer, "string label_%d = \"label number %d\";\n", i, i);
+        bench_appendf(&buffer, "/* checkpoint */ print(value_%d);\n", i);
+    }
+    return buffer;
+}
+
+// This function lexes the whole buffer and returns the number of tokens
+static size_t lex_all(const char *source, size_t length)
+{
+    Lexer *lexer = init_lexer_n(source, length);
+    size_t count = 0;
+    while (next_token(lexer).type != TOKEN_EOF)
+    {
+        count++;
+    }
+    free(lexer);
+    return count;
+}
+
+// This function times lexing the buffer at the current scanning level, in seconds
+static double time_lexing(const BenchBuffer *source, size_t *tokens)
+{
+    // Repeat small inputs so the timer has something to measure
+    int repeats = source->length < 1024 * 1024 ? (int)(16 * 1024 * 1024 / source->length) : 1;
+    double start = bench_now();
+    for (int r = 0; r < repeats; r++)
+    {
+        *tokens = lex_all(source->data, source->length);
+    }
+    return (bench_now() - start) / repeats;
+}
+
+// This function prints one table of throughput by input size and scanning level
+static void run_workload(const char *name, bool generated, size_t max_size)
+{
+    ScanLevel best = scan_best_level();
+
+    printf("%s source\n%12s %12s", name, "bytes", "tokens");
+    for (int level = SCAN_SCALAR; level <= (int)best; level++)
+    {
+        printf(" %7s MB/s", scan_level_name((ScanLevel)level));
+    }
+    printf(" %10s\n", "ns/byte");
+
+    for (size_t size = 1024; size <= max_size; size *= 10)
+    {
+        BenchBuffer source = make_source(size, generated);
+        size_t tokens = 0;
+        double elapsed = 0;
+
+        printf("%12zu", source.length);
+        for (int level = SCAN_SCALAR; level <= (int)best; level++)
+        {
+            scan_set_level((ScanLevel)level);
+            elapsed = time_lexing(&source, &tokens);
+            if (level == SCAN_SCALAR)
+                printf(" %12zu", tokens);
+            printf(" %12.1f", source.length / elapsed / (1024.0 * 1024.0));
+        }
+        printf(" %10.2f\n", elapsed * 1e9 / source.length); // At the best level
+        free(source.data);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_size = (argc > 1 ? (size_t)atol(argv[1]) : 100) * 1024 * 1024;
+    run_workload("typical", false, max_size);
+    run_workload("generated", true, max_size);
+    return 0;
+}
@@ -0,0 +1,383 @@
+// bench_pipeline.c - time and peak memory of every phase of the pipeline
+//
+// Generates four kinds of program of about 8 MB each (or the size given in
+// MB with --size=N): many declarations, deep arithmetic, long string
+// literals and print-heavy scripts. For each, it times lexing, parsing,
+// resolution, type checking, optimization, bytecode compilation, execution
+// on the VM and execution on the tree-walker separately. Parsing pulls its
+// tokens from the lexer, so the parse time has the lexing time subtracted.
+// Each workload runs in its own process, so its peak resident set size can
+// be reported too; with --repeat=N the fastest of N runs is kept. Results
+// are printed as a table, or as JSON (--json) or CSV (--csv) so they can be
+// saved and compared across releases (see `make bench-json`).
+#include "bench.h"
+#include "interpreter/interpreter.h"
+#include "lexer/lexer.h"
+#include "lexer/scan.h"
+#include "optimizer/optimizer.h"
+#include "parser/parser.h"
+#include "semantic/resolver.h"
+#include "semantic/typecheck.h"
+#include "vm/compiler.h"
+#include "vm/vm.h"
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The phases that are timed, in pipeline order
+typedef enum
+{
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_RESOLVE,
+    PHASE_TYPECHECK,
+    PHASE_OPTIMIZE,
+    PHASE_COMPILE,
+    PHASE_RUN_VM,
+    PHASE_RUN_TREE,
+    PHASE_COUNT
+} Phase;
+
+static const char *const phase_names[PHASE_COUNT] = {
+    "lex", "parse", "resolve", "typecheck", "optimize", "compile", "run_vm", "run_tree",
+};
+
+// What one run of a workload measured; sent from the child process to the parent
+typedef struct
+{
+    bool ok;
+    size_t bytes;
+    size_t tokens;
+    size_t statements;
+    double seconds[PHASE_COUNT];
+    long peak_rss_kb;
+} Result;
+
+typedef enum
+{
+    FORMAT_TABLE,
+    FORMAT_JSON,
+    FORMAT_CSV
+} Format;
+
+// Appends statements declaring ints, strings and bools, each initialized from a literal
+static void add_declarations(BenchBuffer *buffer, int i)
+{
+    bench_appendf(buffer, "int count_%d = %d;\n", i, i);
+    bench_appendf(buffer, "string name_%d = \"item %d\";\n", i, i);
+    bench_appendf(buffer, "bool flag_%d = %s;\n", i, i % 2 ? "true" : "false");
+}
+
+// Appends a declaration whose initializer nests operators 24 levels deep. It starts
+// from the previous variable, so the optimizer cannot fold it, and its divisors are
+// non-zero constants, so it never raises a runtime error.
+static void add_arithmetic(BenchBuffer *buffer, int i)
+{
+    static const char *const steps[] = {" + 3)", " * 5)", " - 7)", " % 1009)", " * 3)", " / 2)"};
+
+    if (i == 0)
+    {
+        bench_append(buffer, "int depth_0 = 7;\n", 17);
+        return;
+    }
+    bench_appendf(buffer, "int depth_%d = ", i);
+    for (int level = 0; level < 24; level++)
+    {
+        bench_append(buffer, "(", 1);
+    }
+    bench_appendf(buffer, "depth_%d", i - 1);
+    for (int level = 0; level < 24; level++)
+    {
+        bench_appendf(buffer, "%s", steps[level % 6]);
+    }
+    bench_append(buffer, ";\n", 2);
+}
+
+// Appends a declaration of a string literal of about 1 KB with a few escapes, printed now and then
+static void add_string(BenchBuffer *buffer, int i)
+{
+    bench_appendf(buffer, "string text_%d = \"", i);
+    for (int chunk = 0; chunk < 16; chunk++)
+    {
+        bench_appendf(buffer, "chunk %2d of literal %8d: the quick brown fox jumps\\t\\\"over\\\" it\\n", chunk, i);
+    }
+    bench_append(buffer, "\";\n", 3);
+    if (i % 8 == 0)
+        bench_appendf(buffer, "print(text_%d);\n", i);
+}
+
+// Appends a few declarations followed by prints of every kind of value
+static void add_prints(BenchBuffer *buffer, int i)
+{
+    bench_appendf(buffer, "int line_%d = %d;\n", i, i * 7);
+    bench_appendf(buffer, "print(line_%d);\n", i);
+    bench_appendf(buffer, "print(line_%d * 3 + 1);\n", i);
+    bench_appendf(buffer, "print(\"line %d of the report\");\n", i);
+    bench_appendf(buffer, "print(%s);\n", i % 3 ? "true" : "false");
+}
+
+// The workloads, each built by repeating one statement generator
+typedef struct
+{
+    const char *name;
+    void (*add)(BenchBuffer *buffer, int i);
+} Workload;
+
+static const Workload workloads[] = {
+    {"declarations", add_declarations},
+    {"arithmetic", add_arithmetic},
+    {"strings", add_string},
+    {"prints", add_prints},
+};
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(workloads[0]))
+
+// This function builds a source of at least 'size' bytes out of one workload's statements
+static BenchBuffer make_source(const Workload *workload, size_t size)
+{
+    BenchBuffer buffer = {0};
+    for (int i = 0; buffer.length < size; i++)
+    {
+        workload->add(&buffer, i);
+    }
+    return buffer;
+}
+
+// This function runs the whole pipeline once on a freshly generated source and times each phase
+static Result measure(const Workload *workload, size_t size)
+{
+    Result result;
+    memset(&result, 0, sizeof(result));
+
+    BenchBuffer source = make_source(workload, size);
+    result.bytes = source.length;
+
+    // Lexing on its own, so it can be taken out of the parse time
+    double start = bench_now();
+    Lexer *lexer = init_lexer_n(source.data, source.length);
+    while (next_token(lexer).type != TOKEN_EOF)
+    {
+        result.tokens++;
+    }
+    result.seconds[PHASE_LEX] = bench_now() - start;
+    free(lexer);
+
+    start = bench_now();
+    lexer = init_lexer_n(source.data, source.length);
+    Arena *arena = create_arena(0);
+    Parser *parser = create_parser(lexer, arena);
+    ASTNode *ast = parse_tokens(parser);
+    double parse = bench_now() - start - result.seconds[PHASE_LEX];
+    result.seconds[PHASE_PARSE] = parse > 0 ? parse : 0;
+
+    SymbolTable *symbols = create_symbol_table();
+    start = bench_now();
+    bool ok = ast != NULL && resolve_program(symbols, ast);
+    result.seconds[PHASE_RESOLVE] = bench_now() - start;
+
+    start = bench_now();
+    ok = ok && typecheck_program(ast, symbols->slot_count);
+    result.seconds[PHASE_TYPECHECK] = bench_now() - start;
+
+    start = bench_now();
+    ok = ok && optimize_program(ast, OPT_LEVEL_DEFAULT);
+    result.seconds[PHASE_OPTIMIZE] = bench_now() - start;
+
+    start = bench_now();
+    Chunk *chunk = ok ? compile_to_bytecode(ast, symbols->slot_count) : NULL;
+    result.seconds[PHASE_COMPILE] = bench_now() - start;
+
+    if (chunk != NULL)
+    {
+        for (ASTNode *node = ast; node != NULL; node = node->next)
+        {
+            result.statements++;
+        }
+
+        // Program output goes to /dev/null so the terminal's speed is not measured
+        int null_fd = open("/dev/null", O_WRONLY);
+        Output *out = create_output(null_fd);
+
+        start = bench_now();
+        run_bytecode(chunk, out);
+        output_flush(out);
+        result.seconds[PHASE_RUN_VM] = bench_now() - start;
+
+        start = bench_now();
+        interpret(ast, symbols->slot_count, out, false);
+        output_flush(out);
+        result.seconds[PHASE_RUN_TREE] = bench_now() - start;
+
+        free_output(out);
+        close(null_fd);
+        free_chunk(chunk);
+        result.ok = true;
+    }
+
+    free_symbol_table(symbols);
+    free_parser(parser);
+    free_arena(arena);
+    free(lexer);
+    free(source.data);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peak_rss_kb = usage.ru_maxrss; // Kilobytes on Linux
+    return result;
+}
+
+// This function measures a workload in a child process, so the peak RSS is the workload's own
+static bool measure_in_child(const Workload *workload, size_t size, Result *result)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("bench: pipe");
+        return false;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("bench: fork");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        Result child = measure(workload, size);
+        ssize_t written = write(fds[1], &child, sizeof(child));
+        _exit(written == (ssize_t)sizeof(child) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*result) && WIFEXITED(status) && WEXITSTATUS(status) == 0 && result->ok;
+}
+
+// This function keeps the fastest time of each phase and the largest peak RSS over several runs
+static void merge_result(Result *best, const Result *run, bool first)
+{
+    if (first)
+    {
+        *best = *run;
+        return;
+    }
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        if (run->seconds[phase] < best->seconds[phase])
+            best->seconds[phase] = run->seconds[phase];
+    }
+    if (run->peak_rss_kb > best->peak_rss_kb)
+        best->peak_rss_kb = run->peak_rss_kb;
+}
+
+static void print_header(Format format, size_t size_mb, int repeats)
+{
+    if (format == FORMAT_JSON)
+    {
+        printf("{\n  \"benchmark\": \"pipeline\",\n  \"size_mb\": %zu,\n  \"repeats\": %d,\n", size_mb, repeats);
+        printf("  \"scan_level\": \"%s\",\n  \"workloads\": [", scan_level_name(scan_best_level()));
+        return;
+    }
+
+    if (format == FORMAT_CSV)
+    {
+        printf("workload,bytes,tokens,statements");
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+            printf(",%s_ms", phase_names[phase]);
+        printf(",peak_rss_kb\n");
+        return;
+    }
+
+    printf("%-13s %10s %10s", "workload", "MB", "stmts");
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        printf(" %9s", phase_names[phase]);
+    printf(" %10s\n", "peak MB");
+    printf("%-13s %10s %10s", "", "", "");
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        printf(" %9s", "ms");
+    printf("\n");
+}
+
+static void print_result(Format format, const char *name, const Result *result, bool first)
+{
+    if (format == FORMAT_JSON)
+    {
+        printf("%s\n    {\"name\": \"%s\", \"bytes\": %zu, \"tokens\": %zu, \"statements\": %zu,", first ? "" : ",",
+               name, result->bytes, result->tokens, result->statements);
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+            printf(" \"%s_ms\": %.3f,", phase_names[phase], result->seconds[phase] * 1e3);
+        printf(" \"peak_rss_kb\": %ld}", result->peak_rss_kb);
+        return;
+    }
+
+    if (format == FORMAT_CSV)
+    {
+        printf("%s,%zu,%zu,%zu", name, result->bytes, result->tokens, result->statements);
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+            printf(",%.3f", result->seconds[phase] * 1e3);
+        printf(",%ld\n", result->peak_rss_kb);
+        return;
+    }
+
+    printf("%-13s %10.1f %10zu", name, result->bytes / (1024.0 * 1024.0), result->statements);
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        printf(" %9.1f", result->seconds[phase] * 1e3);
+    printf(" %10.1f\n", result->peak_rss_kb / 1024.0);
+}
+
+static void print_footer(Format format)
+{
+    if (format == FORMAT_JSON)
+        printf("\n  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Format format = FORMAT_TABLE;
+    size_t size_mb = 8;
+    int repeats = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            format = FORMAT_JSON;
+        else if (strcmp(argv[i], "--csv") == 0)
+            format = FORMAT_CSV;
+        else if (strncmp(argv[i], "--size=", 7) == 0 && atoi(argv[i] + 7) > 0)
+            size_mb = (size_t)atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "--repeat=", 9) == 0 && atoi(argv[i] + 9) > 0)
+            repeats = atoi(argv[i] + 9);
+        else
+        {
+            fprintf(stderr, "usage: %s [--json | --csv] [--size=MB] [--repeat=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    print_header(format, size_mb, repeats);
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++)
+    {
+        Result best;
+        for (int r = 0; r < repeats; r++)
+        {
+            Result run;
+            if (!measure_in_child(&workloads[w], size_mb * 1024 * 1024, &run))
+            {
+                fprintf(stderr, "bench: the %s workload failed\n", workloads[w].name);
+                return 1;
+            }
+            merge_result(&best, &run, r == 0);
+        }
+        print_result(format, workloads[w].name, &best, w == 0);
+    }
+    print_footer(format);
+    return 0;
+}
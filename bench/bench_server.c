@@ -0,0 +1,186 @@
+// bench_server.c - request latency: a cold a++c process against a warm --serve server
+//
+// Starts `a++c --serve` (the a++c executable is the first argument, default
+// ./build/bin/a++c) on a temporary socket, then runs a small and a medium
+// script many times (200 by default, or the count given as the second
+// argument) in three ways, reporting the median and 99th percentile latency:
+//   - cold:    one `a++c script` process per request, which builds the program every time;
+//   - connect: one `a++c --connect` process per request, a thin client of the server;
+//   - request: request_run() from this process, the bare round trip to the server.
+// The server's reply is compared with the cold output first.
+#include "bench.h"
+#include "server/server.h"
+#include <signal.h>
+
+#define DEFAULT_REQUEST_COUNT 200
+
+// This function writes a script of about 'lines' statements
+static bool write_script(const char *path, int lines)
+{
+    BenchBuffer buffer = {0};
+    bench_appendf(&buffer, "int total = 1;\nstring name = \"%d lines\";\n", lines);
+    for (int i = 0; i < lines / 2; i++)
+    {
+        bench_appendf(&buffer, "int v%d = (total * %d + %d) %% 9973;\n", i, i + 3, lines);
+        bench_appendf(&buffer, "total = total + v%d ** 2 / (%d + 1);\n", i, i);
+    }
+    bench_appendf(&buffer, "print(name);\nprint(total);\n");
+
+    FILE *file = fopen(path, "w");
+    bool ok = file != NULL && fwrite(buffer.data, 1, buffer.length, file) == buffer.length;
+    if (file != NULL)
+        ok = fclose(file) == 0 && ok;
+    free(buffer.data);
+    return ok;
+}
+
+// This function runs a script once and returns what it printed
+static BenchBuffer capture_output(char *const args[], const char *scratch_path)
+{
+    BenchBuffer buffer = {0};
+    int fd = open(scratch_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0 && bench_run_process(args, fd))
+    {
+        char block[65536];
+        ssize_t got;
+        lseek(fd, 0, SEEK_SET);
+        while ((got = read(fd, block, sizeof(block))) > 0)
+        {
+            bench_append(&buffer, block, (size_t)got);
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+    return buffer;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// This function prints the median and 99th percentile of 'count' latencies (sorted in place)
+static void print_latencies(const char *script, const char *mode, double *seconds, int count)
+{
+    qsort(seconds, (size_t)count, sizeof(double), compare_doubles);
+    double p50 = seconds[(count - 1) / 2];
+    double p99 = seconds[(int)((count - 1) * 0.99)];
+    printf("%-8s %-8s %10.3f %10.3f\n", script, mode, p50 * 1e3, p99 * 1e3);
+}
+
+int main(int argc, char *argv[])
+{
+    char *program = argc > 1 ? argv[1] : "./build/bin/a++c";
+    int count = argc > 2 ? atoi(argv[2]) : DEFAULT_REQUEST_COUNT;
+    if (access(program, X_OK) != 0 || count < 1)
+    {
+        printf("Usage: bench_server [path to a++c] [requests per mode]   (build a++c with 'make' first)\n");
+        return 1;
+    }
+
+    char dir[] = "/tmp/a++-bench-server-XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("bench: mkdtemp");
+        return 1;
+    }
+    char socket_path[sizeof(dir) + 16];
+    char scratch_path[sizeof(dir) + 16];
+    char small_path[sizeof(dir) + 16];
+    char medium_path[sizeof(dir) + 16];
+    snprintf(socket_path, sizeof(socket_path), "%s/socket", dir);
+    snprintf(scratch_path, sizeof(scratch_path), "%s/out", dir);
+    snprintf(small_path, sizeof(small_path), "%s/small.a++", dir);
+    snprintf(medium_path, sizeof(medium_path), "%s/medium.a++", dir);
+    if (!write_script(small_path, 20) || !write_script(medium_path, 4000))
+    {
+        perror("bench: script");
+        return 1;
+    }
+
+    // Start the server and wait for its socket to appear
+    char serve_option[sizeof(socket_path) + 16];
+    char connect_option[sizeof(socket_path) + 16];
+    snprintf(serve_option, sizeof(serve_option), "--serve=%s", socket_path);
+    snprintf(connect_option, sizeof(connect_option), "--connect=%s", socket_path);
+    char *serve_args[] = {program, serve_option, NULL};
+    int null_fd = open("/dev/null", O_WRONLY);
+    pid_t server = bench_start_process(serve_args, null_fd);
+    for (int i = 0; i < 500 && server > 0 && access(socket_path, F_OK) != 0; i++)
+    {
+        usleep(10000);
+    }
+    if (server <= 0 || access(socket_path, F_OK) != 0)
+    {
+        printf("Error: The server did not start.\n");
+        return 1;
+    }
+
+    printf("%d requests per mode\n", count);
+    printf("%-8s %-8s %10s %10s\n", "script", "mode", "p50 ms", "p99 ms");
+    const char *names[] = {"small", "medium"};
+    char *paths[] = {small_path, medium_path};
+    double *seconds = malloc((size_t)count * sizeof(double));
+    int status = 0;
+    for (int s = 0; s < 2 && status == 0; s++)
+    {
+        char *cold_args[] = {program, paths[s], NULL};
+        char *connect_args[] = {program, connect_option, paths[s], NULL};
+
+        // Check the server prints what a cold run prints, through both clients
+        BenchBuffer expected = capture_output(cold_args, scratch_path);
+        BenchBuffer connected = capture_output(connect_args, scratch_path);
+        ServerReply reply = {0};
+        bool answered = request_run(socket_path, paths[s], ENGINE_VM, OPT_LEVEL_DEFAULT, &reply);
+        bool same = answered && reply.status == 0 && reply.output_length == expected.length &&
+                    memcmp(reply.output, expected.data, expected.length) == 0 &&
+                    connected.length == expected.length && memcmp(connected.data, expected.data, expected.length) == 0;
+        free_server_reply(&reply);
+        if (!same)
+        {
+            printf("Error: The server printed something other than a cold run of the %s script.\n", names[s]);
+            status = 1;
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+            {
+                double start = bench_now();
+                bench_run_process(cold_args, null_fd);
+                seconds[i] = bench_now() - start;
+            }
+            print_latencies(names[s], "cold", seconds, count);
+
+            for (int i = 0; i < count; i++)
+            {
+                double start = bench_now();
+                bench_run_process(connect_args, null_fd);
+                seconds[i] = bench_now() - start;
+            }
+            print_latencies(names[s], "connect", seconds, count);
+
+            for (int i = 0; i < count; i++)
+            {
+                double start = bench_now();
+                request_run(socket_path, paths[s], ENGINE_VM, OPT_LEVEL_DEFAULT, &reply);
+                seconds[i] = bench_now() - start;
+                free_server_reply(&reply);
+            }
+            print_latencies(names[s], "request", seconds, count);
+        }
+        free(expected.data);
+        free(connected.data);
+    }
+
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+    close(null_fd);
+    free(seconds);
+    unlink(small_path);
+    unlink(medium_path);
+    unlink(scratch_path);
+    rmdir(dir);
+    return status;
+}
@@ -5,10 +5,10 @@
 #include "ast.h"     // This includes our custom Abstract Syntax Tree (AST) header file
 
 // This function creates a new AST node
-ASTNode *create_node(ASTNodeType type, ASTNode *left, ASTNode *right, const char *value)
+ASTNode *create_node(Arena *arena, ASTNodeType type, ASTNode *left, ASTNode *right, const char *value)
 {
-    // Allocate memory for a new ASTNode
-    ASTNode *node = (ASTNode *)malloc(sizeof(ASTNode));
+    // Allocate a new ASTNode from the arena (arena memory is zeroed, so unused fields and 'next' start out NULL)
+    ASTNode *node = (ASTNode *)arena_alloc(arena, sizeof(ASTNode));
     
     // Set the type of the node (e.g., variable declaration, print statement, etc.)
     node->type = type;
@@ -19,19 +19,79 @@ ASTNode *create_node(ASTNodeType type, ASTNode *left, ASTNode *right, const char
     // Set the right child of the node
     node->right = right;
     
-    // If a value was provided, make a copy of it and store it in the node
-    // If no value was provided, set it to NULL
-    node->value = value ? strdup(value) : NULL;
+    // Store the value (if any); it already lives in the arena or in static storage
+    node->value = value;
     
     // Return the newly created node
     return node;
 }
 
+// This function creates an integer literal; the parser has already decoded its value
+ASTNode *create_int_literal_node(Arena *arena, int value)
+{
+    ASTNode *node = create_node(arena, NODE_INT_LITERAL, NULL, NULL, NULL);
+    node->value_type = INT_TYPE;
+    node->int_value = value;
+    return node;
+}
+
+// This function creates a boolean literal
+ASTNode *create_bool_literal_node(Arena *arena, bool value)
+{
+    ASTNode *node = create_node(arena, NODE_BOOL_LITERAL, NULL, NULL, NULL);
+    node->value_type = BOOL_TYPE;
+    node->bool_value = value;
+    return node;
+}
+
+// This function creates a floating-point literal
+ASTNode *create_float_literal_node(Arena *arena, double value)
+{
+    ASTNode *node = create_node(arena, NODE_FLOAT_LITERAL, NULL, NULL, NULL);
+    node->value_type = FLOAT_TYPE;
+    node->float_value = value;
+    return node;
+}
+
+// This function creates a string literal; its length is kept so printing never needs strlen
+ASTNode *create_string_literal_node(Arena *arena, const char *value, size_t length)
+{
+    ASTNode *node = create_node(arena, NODE_STRING_LITERAL, NULL, NULL, value);
+    node->value_type = STRING_TYPE;
+    node->value_length = length;
+    return node;
+}
+
+// This function creates a binary operator node; the operator is stored as an enum, not as text
+ASTNode *create_binary_op_node(Arena *arena, BinaryOperator op, ASTNode *left, ASTNode *right)
+{
+    ASTNode *node = create_node(arena, NODE_BINARY_OP, left, right, NULL);
+    node->value_type = INT_TYPE;
+    node->op = op;
+    return node;
+}
+
+// Spellings of the binary operators, indexed by BinaryOperator
+static const char *binary_operator_names[BINOP_COUNT] = {
+    [BINOP_ADD] = "+",
+    [BINOP_SUB] = "-",
+    [BINOP_MUL] = "*",
+    [BINOP_DIV] = "/",
+    [BINOP_MOD] = "%",
+    [BINOP_POW] = "**",
+};
+
+// This function returns how an operator is written in source code
+const char *binary_operator_name(BinaryOperator op)
+{
+    return (unsigned)op < BINOP_COUNT ? binary_operator_names[op] : "?";
+}
+
 // This function creates a node specifically for variable declarations
-ASTNode *create_var_declaration_node(char *type, char *var_name, ASTNode *value)
+ASTNode *create_var_declaration_node(Arena *arena, const char *type, const char *var_name, ASTNode *value)
 {
-    // Allocate memory for a new ASTNode
-    ASTNode *node = (ASTNode *)malloc(sizeof(ASTNode));
+    // Allocate a new ASTNode from the arena
+    ASTNode *node = (ASTNode *)arena_alloc(arena, sizeof(ASTNode));
     
     // Set the type of the node to variable declaration
     node->type = NODE_VAR_DECLARATION;
@@ -53,16 +113,16 @@ ASTNode *create_var_declaration_node(char *type, char *var_name, ASTNode *value)
 }
 
 // This function creates a node specifically for assignment statements
-ASTNode *create_assignment_node(char *var_name, ASTNode *value)
+ASTNode *create_assignment_node(Arena *arena, const char *var_name, ASTNode *value)
 {
-    // Allocate memory for a new ASTNode
-    ASTNode *node = (ASTNode *)malloc(sizeof(ASTNode));
+    // Allocate a new ASTNode from the arena
+    ASTNode *node = (ASTNode *)arena_alloc(arena, sizeof(ASTNode));
     
     // Set the type of the node to assignment
     node->type = NODE_ASSIGNMENT;
     
-    // Make a copy of the variable name and store it
-    node->var_name = strdup(var_name);
+    // Store the variable name
+    node->var_name = var_name;
     
     // The left child will hold the value/expression being assigned to the variable
     node->left = value;
@@ -73,32 +133,3 @@ ASTNode *create_assignment_node(char *var_name, ASTNode *value)
     // Return the newly created node
     return node;
 }
-
-// This function frees the memory allocated for an AST
-void free_ast(ASTNode *node)
-{
-    // If the node is NULL, there's nothing to free
-    if (node)
-    {
-        // Recursively free the left subtree
-        free_ast(node->left);
-        
-        // Recursively free the right subtree
-        free_ast(node->right);
-        
-        // Free the value if it exists
-        free(node->value);
-        
-        // Free the variable type if it exists
-        free(node->var_type);
-        
-        // Free the variable name if it exists
-        free(node->var_name);
-        
-        // Recursively free the next node in the list
-        free_ast(node->next);
-        
-        // Finally, free the node itself
-        free(node);
-    }
-}
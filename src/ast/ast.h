@@ -3,7 +3,9 @@
 #define AST_H
 
 #include "common/types.h"
+#include "common/arena.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef enum
 {
@@ -20,54 +22,138 @@ typedef enum
     NODE_BOOL_LITERAL
 } ASTNodeType;
 
+// Operators of NODE_BINARY_OP nodes; engines dispatch on these instead of on spellings
+typedef enum
+{
+    BINOP_ADD, // +
+    BINOP_SUB, // -
+    BINOP_MUL, // *
+    BINOP_DIV, // /
+    BINOP_MOD, // %
+    BINOP_POW, // **
+    BINOP_COUNT
+} BinaryOperator;
+
 typedef struct ASTNode
 {
     ASTNodeType type;
     struct ASTNode *left;
     struct ASTNode *right;
 
-    char *var_type;
-    char *var_name;
-    char *value;
+    // Strings produced by the parser are interned (see common/intern.h):
+    // equal names share one pointer, and type names are the INTERN_TYPE_* pointers
+    const char *var_type;
+    const char *var_name;
+    const char *value;
     struct ASTNode *next;
-    int int_value;
+
+    // Typed payload of a literal or operator node, decoded once by the parser
+    union
+    {
+        int int_value;      // NODE_INT_LITERAL
+        bool bool_value;    // NODE_BOOL_LITERAL
+        double float_value; // NODE_FLOAT_LITERAL
+        BinaryOperator op;  // NODE_BINARY_OP
+    };
+    size_t value_length; // Length of 'value' in bytes (string literals)
+
+    int slot; // Variable slot bound by the resolver (identifiers, assignments, declarations)
+
+    // Type of the value, set by the type checker (see semantic/typecheck.h); for
+    // declarations and assignments it is the variable's type
+    VariableType value_type;
 } ASTNode;
 
 /**
  * @brief Creates a new AST node.
+ *
+ * Nodes are allocated from the arena, which owns the whole tree; there is no
+ * per-node free. Releasing the arena releases the AST.
  * 
+ * @param arena The arena that owns the AST.
  * @param type The type of the node.
  * @param left The left child node.
  * @param right The right child node.
- * @param value The value associated with the node (if any).
+ * @param value The value associated with the node (if any), allocated from the same arena or static.
  * @return ASTNode* A pointer to the newly created ASTNode.
  */
-ASTNode *create_node(ASTNodeType type, ASTNode *left, ASTNode *right, const char *value);
+ASTNode *create_node(Arena *arena, ASTNodeType type, ASTNode *left, ASTNode *right, const char *value);
+
+/**
+ * @brief Creates an integer literal node carrying its decoded value.
+ *
+ * @param arena The arena that owns the AST.
+ * @param value The value of the literal.
+ * @return ASTNode* A pointer to the newly created node.
+ */
+ASTNode *create_int_literal_node(Arena *arena, int value);
+
+/**
+ * @brief Creates a boolean literal node carrying its decoded value.
+ *
+ * @param arena The arena that owns the AST.
+ * @param value The value of the literal.
+ * @return ASTNode* A pointer to the newly created node.
+ */
+ASTNode *create_bool_literal_node(Arena *arena, bool value);
+
+/**
+ * @brief Creates a floating-point literal node carrying its decoded value.
+ *
+ * @param arena The arena that owns the AST.
+ * @param value The value of the literal.
+ * @return ASTNode* A pointer to the newly created node.
+ */
+ASTNode *create_float_literal_node(Arena *arena, double value);
+
+/**
+ * @brief Creates a string literal node.
+ *
+ * @param arena The arena that owns the AST.
+ * @param value The text of the literal, allocated from the same arena.
+ * @param length The length of the text in bytes.
+ * @return ASTNode* A pointer to the newly created node.
+ */
+ASTNode *create_string_literal_node(Arena *arena, const char *value, size_t length);
+
+/**
+ * @brief Creates a binary operator node.
+ *
+ * @param arena The arena that owns the AST.
+ * @param op The operator.
+ * @param left The left operand.
+ * @param right The right operand.
+ * @return ASTNode* A pointer to the newly created node.
+ */
+ASTNode *create_binary_op_node(Arena *arena, BinaryOperator op, ASTNode *left, ASTNode *right);
+
+/**
+ * @brief Returns the source spelling of a binary operator (e.g. "**"), for messages and listings.
+ *
+ * @param op The operator.
+ * @return const char* A static string.
+ */
+const char *binary_operator_name(BinaryOperator op);
 
 /**
  * @brief Creates a variable declaration node.
  * 
- * @param type The type of the variable (e.g., "int", "string").
- * @param var_name The name of the variable.
+ * @param arena The arena that owns the AST.
+ * @param type The type of the variable (e.g., "int", "string"), interned.
+ * @param var_name The name of the variable, interned.
  * @param value The initial value of the variable (if any).
  * @return ASTNode* A pointer to the newly created variable declaration node.
  */
-ASTNode *create_var_declaration_node(char *type, char *var_name, ASTNode *value);
+ASTNode *create_var_declaration_node(Arena *arena, const char *type, const char *var_name, ASTNode *value);
 
 /**
  * @brief Creates an assignment node.
  * 
- * @param var_name The name of the variable being assigned.
+ * @param arena The arena that owns the AST.
+ * @param var_name The name of the variable being assigned, interned.
  * @param value The value being assigned to the variable.
  * @return ASTNode* A pointer to the newly created assignment node.
  */
-ASTNode *create_assignment_node(char *var_name, ASTNode *value);
-
-/**
- * @brief Frees the memory allocated for an AST.
- * 
- * @param node The root node of the AST to be freed.
- */
-void free_ast(ASTNode *node);
+ASTNode *create_assignment_node(Arena *arena, const char *var_name, ASTNode *value);
 
 #endif // AST_H
@@ -0,0 +1,492 @@
+#include "cache.h"
+#include "common/intern.h"
+#include "common/trace.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The file starts with a header, followed by 'node_count' CachedNode records
+// in pre-order and then 'string_bytes' of NUL-terminated strings. Links
+// between nodes are record indices plus one (0 means NULL) and always point
+// forward, so a damaged file can never make a cycle. The layout is that of
+// the machine that wrote it; the byte order mark rejects files from others.
+
+#define CACHE_MAGIC "A++AST\n"
+#define CACHE_BYTE_ORDER 0x01020304u
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;    // CACHE_FORMAT_VERSION
+    uint32_t byte_order; // CACHE_BYTE_ORDER as written by this machine
+    uint64_t key;        // The key the file is named after
+    uint64_t slot_count;
+    uint64_t node_count;
+    uint64_t string_bytes;
+} CacheHeader;
+
+typedef struct
+{
+    uint32_t type;       // ASTNodeType
+    uint32_t value_type; // VariableType
+    uint32_t left;       // Links: record index + 1, or 0
+    uint32_t right;
+    uint32_t next;
+    int32_t slot;
+    uint32_t var_type;   // Which INTERN_TYPE_* name, as a CachedTypeName
+    uint32_t var_name;   // Strings: offset in the string table + 1, or 0
+    uint32_t value;
+    uint32_t padding;
+    uint64_t value_length;
+    uint64_t payload; // The bits of the node's typed payload (int_value, bool_value, float_value or op)
+} CachedNode;
+
+// Declarations name their type with one of the interned type names
+typedef enum
+{
+    CACHED_TYPE_NONE,
+    CACHED_TYPE_INT,
+    CACHED_TYPE_FLOAT,
+    CACHED_TYPE_STRING,
+    CACHED_TYPE_BOOL,
+    CACHED_TYPE_COUNT
+} CachedTypeName;
+
+// This function mixes the bits of 'hash' (the MurmurHash3 finalizer)
+static uint64_t mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// This function hashes the source eight bytes at a time, so scripts of any size hash quickly
+uint64_t cache_key(const char *source, size_t length, int opt_level)
+{
+    uint64_t hash = mix(0x9E3779B97F4A7C15ull ^ length ^ ((uint64_t)opt_level << 56) ^ ((uint64_t)CACHE_FORMAT_VERSION << 48));
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, source + i, sizeof(word));
+        hash = (hash ^ mix(word)) * 0x9E3779B97F4A7C15ull;
+    }
+    uint64_t tail = 0;
+    if (i < length)
+    {
+        memcpy(&tail, source + i, length - i);
+    }
+    return mix(hash ^ mix(tail ^ 0xA5));
+}
+
+// This function builds the path of the file holding 'key'
+static void cache_path(char *path, size_t size, const char *dir, uint64_t key)
+{
+    snprintf(path, size, "%s/%016llx.astc", dir, (unsigned long long)key);
+}
+
+// State carried while a program is written
+typedef struct
+{
+    CachedNode *nodes;
+    size_t node_count;
+    size_t node_capacity;
+
+    char *strings; // The string table being built
+    size_t string_bytes;
+    size_t string_capacity;
+
+    // Strings already in the table, by address: the AST's strings are
+    // interned, so equal strings share an address and are stored once
+    const char **seen;
+    uint32_t *seen_offsets;
+    size_t seen_capacity; // Always a power of two
+    size_t seen_count;
+} CacheWriter;
+
+// This function appends bytes to the string table and returns where they start
+static size_t append_string_bytes(CacheWriter *writer, const char *text, size_t length)
+{
+    if (writer->string_bytes + length + 1 > writer->string_capacity)
+    {
+        size_t capacity = writer->string_capacity ? writer->string_capacity : 4096;
+        while (writer->string_bytes + length + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+        writer->strings = realloc(writer->strings, capacity);
+        if (!writer->strings)
+        {
+            printf("Error: Failed to allocate memory for the cache file.\n");
+            exit(1);
+        }
+        writer->string_capacity = capacity;
+    }
+    size_t offset = writer->string_bytes;
+    memcpy(writer->strings + offset, text, length);
+    writer->strings[offset + length] = '\0';
+    writer->string_bytes += length + 1;
+    return offset;
+}
+
+// This function finds the bucket of 'text' in the table of strings already written
+static size_t find_seen(const CacheWriter *writer, const char *text)
+{
+    size_t mask = writer->seen_capacity - 1;
+    size_t index = (size_t)mix((uint64_t)(uintptr_t)text) & mask;
+    while (writer->seen[index] != NULL && writer->seen[index] != text)
+    {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+// This function doubles the table of strings already written
+static void grow_seen(CacheWriter *writer)
+{
+    const char **old = writer->seen;
+    uint32_t *old_offsets = writer->seen_offsets;
+    size_t old_capacity = writer->seen_capacity;
+
+    writer->seen_capacity = old_capacity ? old_capacity * 2 : 256;
+    writer->seen = calloc(writer->seen_capacity, sizeof(const char *));
+    writer->seen_offsets = calloc(writer->seen_capacity, sizeof(uint32_t));
+    if (!writer->seen || !writer->seen_offsets)
+    {
+        printf("Error: Failed to allocate memory for the cache file.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i] != NULL)
+        {
+            size_t index = find_seen(writer, old[i]);
+            writer->seen[index] = old[i];
+            writer->seen_offsets[index] = old_offsets[i];
+        }
+    }
+    free(old);
+    free(old_offsets);
+}
+
+// This function returns the string reference stored in a record: its offset + 1, or 0 for NULL
+static bool add_string(CacheWriter *writer, const char *text, size_t length, uint32_t *reference)
+{
+    if (text == NULL)
+    {
+        *reference = 0;
+        return true;
+    }
+    if ((writer->seen_count + 1) * 2 > writer->seen_capacity)
+    {
+        grow_seen(writer);
+    }
+    size_t index = find_seen(writer, text);
+    if (writer->seen[index] == NULL)
+    {
+        size_t offset = append_string_bytes(writer, text, length);
+        if (offset >= UINT32_MAX)
+        {
+            return false;
+        }
+        writer->seen[index] = text;
+        writer->seen_offsets[index] = (uint32_t)offset + 1;
+        writer->seen_count++;
+    }
+    *reference = writer->seen_offsets[index];
+    return true;
+}
+
+static CachedTypeName type_name_code(const char *name)
+{
+    if (name == INTERN_TYPE_INT)
+        return CACHED_TYPE_INT;
+    if (name == INTERN_TYPE_FLOAT)
+        return CACHED_TYPE_FLOAT;
+    if (name == INTERN_TYPE_STRING)
+        return CACHED_TYPE_STRING;
+    if (name == INTERN_TYPE_BOOL)
+        return CACHED_TYPE_BOOL;
+    return CACHED_TYPE_NONE;
+}
+
+// This function writes 'node' and its operands in pre-order and returns the record index + 1
+static bool add_node(CacheWriter *writer, const ASTNode *node, uint32_t *reference)
+{
+    if (node == NULL)
+    {
+        *reference = 0;
+        return true;
+    }
+    if (writer->node_count >= UINT32_MAX - 1)
+    {
+        return false;
+    }
+
+    if (writer->node_count == writer->node_capacity)
+    {
+        writer->node_capacity = writer->node_capacity ? writer->node_capacity * 2 : 1024;
+        writer->nodes = realloc(writer->nodes, writer->node_capacity * sizeof(CachedNode));
+        if (!writer->nodes)
+        {
+            printf("Error: Failed to allocate memory for the cache file.\n");
+            exit(1);
+        }
+    }
+    size_t index = writer->node_count++;
+    CachedNode record;
+    memset(&record, 0, sizeof(record));
+    record.type = (uint32_t)node->type;
+    record.value_type = (uint32_t)node->value_type;
+    record.slot = node->slot;
+    record.var_type = (uint32_t)type_name_code(node->var_type);
+    record.value_length = node->value_length;
+    memcpy(&record.payload, &node->float_value, sizeof(node->float_value)); // The whole payload union
+
+    // Names are NUL-terminated; string literals carry their length
+    size_t value_length = node->type == NODE_STRING_LITERAL ? node->value_length : (node->value ? strlen(node->value) : 0);
+    if (!add_string(writer, node->var_name, node->var_name ? strlen(node->var_name) : 0, &record.var_name) ||
+        !add_string(writer, node->value, value_length, &record.value) ||
+        !add_node(writer, node->left, &record.left) ||
+        !add_node(writer, node->right, &record.right))
+    {
+        return false;
+    }
+
+    writer->nodes[index] = record; // 'nodes' may have moved while the operands were added
+    *reference = (uint32_t)index + 1;
+    return true;
+}
+
+// This function writes the whole file under a temporary name, then renames it into place
+static bool write_file(const char *dir, uint64_t key, const CacheWriter *writer, size_t slot_count)
+{
+    char path[4096];
+    char temporary[4096 + 32];
+    cache_path(path, sizeof(path), dir, key);
+    snprintf(temporary, sizeof(temporary), "%s.XXXXXX", path);
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_FORMAT_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.key = key;
+    header.slot_count = slot_count;
+    header.node_count = writer->node_count;
+    header.string_bytes = writer->string_bytes;
+
+    // A unique temporary name, so threads and processes storing the same key never share one
+    int fd = mkstemp(temporary);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (file == NULL)
+    {
+        TRACE_INFO(TRACE_CACHE, "Cannot create %s: %s", temporary, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(temporary);
+        }
+        return false;
+    }
+    fchmod(fd, 0644); // mkstemp() makes the file private; cache files are as readable as the scripts
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(writer->nodes, sizeof(CachedNode), writer->node_count, file) == writer->node_count &&
+              fwrite(writer->strings, 1, writer->string_bytes, file) == writer->string_bytes;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, path) != 0)
+    {
+        TRACE_INFO(TRACE_CACHE, "Cannot write %s: %s", path, strerror(errno));
+        unlink(temporary);
+        return false;
+    }
+    TRACE_INFO(TRACE_CACHE, "Stored %zu nodes and %zu string bytes in %s", writer->node_count, writer->string_bytes, path);
+    return true;
+}
+
+// This function serializes the statements in order; each statement's 'next' is patched once the next one is written
+bool cache_store(const char *dir, uint64_t key, const ASTNode *ast, size_t slot_count)
+{
+    mkdir(dir, 0777); // Fails harmlessly if it already exists
+
+    CacheWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    bool ok = true;
+    size_t previous = SIZE_MAX;
+    for (const ASTNode *node = ast; node != NULL && ok; node = node->next)
+    {
+        uint32_t reference = 0;
+        ok = add_node(&writer, node, &reference);
+        if (ok && previous != SIZE_MAX)
+        {
+            writer.nodes[previous].next = reference;
+        }
+        previous = reference - 1;
+    }
+
+    ok = ok && write_file(dir, key, &writer, slot_count);
+    free(writer.nodes);
+    free(writer.strings);
+    free(writer.seen);
+    free(writer.seen_offsets);
+    return ok;
+}
+
+// This function turns a string reference into a pointer into the mapped string table
+static bool resolve_string(const char *strings, uint64_t string_bytes, uint32_t reference, const char **text)
+{
+    if (reference == 0)
+    {
+        *text = NULL;
+        return true;
+    }
+    if (reference > string_bytes)
+    {
+        return false;
+    }
+    *text = strings + reference - 1;
+    return true;
+}
+
+// This function checks that a link stays inside the file and points forward
+static bool resolve_link(ASTNode *nodes, uint64_t node_count, size_t from, uint32_t reference, ASTNode **link)
+{
+    if (reference == 0)
+    {
+        *link = NULL;
+        return true;
+    }
+    if (reference > node_count || reference - 1 <= from)
+    {
+        return false;
+    }
+    *link = &nodes[reference - 1];
+    return true;
+}
+
+// This function rebuilds one node from its record, rejecting truncated or malformed records.
+// Type annotations are trusted as written: the file is not type checked again.
+static bool load_node(ASTNode *nodes, size_t index, const CachedNode *record, const CacheHeader *header, const char *strings)
+{
+    static const char *const type_names[CACHED_TYPE_COUNT] = {
+        [CACHED_TYPE_NONE] = NULL,
+        [CACHED_TYPE_INT] = INTERN_TYPE_INT,
+        [CACHED_TYPE_FLOAT] = INTERN_TYPE_FLOAT,
+        [CACHED_TYPE_STRING] = INTERN_TYPE_STRING,
+        [CACHED_TYPE_BOOL] = INTERN_TYPE_BOOL,
+    };
+
+    ASTNode *node = &nodes[index];
+    if (record->type > NODE_BOOL_LITERAL || record->value_type > BOOL_TYPE || record->var_type >= CACHED_TYPE_COUNT ||
+        record->slot < 0 || (uint64_t)record->slot >= (header->slot_count ? header->slot_count : 1))
+    {
+        return false;
+    }
+    node->type = (ASTNodeType)record->type;
+    node->value_type = (VariableType)record->value_type;
+    node->slot = record->slot;
+    node->var_type = type_names[record->var_type];
+    node->value_length = (size_t)record->value_length;
+    memcpy(&node->float_value, &record->payload, sizeof(node->float_value));
+
+    if (!resolve_string(strings, header->string_bytes, record->var_name, &node->var_name) ||
+        !resolve_string(strings, header->string_bytes, record->value, &node->value) ||
+        !resolve_link(nodes, header->node_count, index, record->left, &node->left) ||
+        !resolve_link(nodes, header->node_count, index, record->right, &node->right) ||
+        !resolve_link(nodes, header->node_count, index, record->next, &node->next))
+    {
+        return false;
+    }
+
+    // A string literal's bytes, plus its terminator, must lie inside the string table
+    if (node->value != NULL && record->value_length > header->string_bytes - (record->value - 1) - 1)
+    {
+        return false;
+    }
+
+    // Every node must have the operands and names the engines read without checking
+    switch (node->type)
+    {
+    case NODE_BINARY_OP:
+        return node->left != NULL && node->right != NULL && (unsigned)node->op < BINOP_COUNT;
+    case NODE_PRINT:
+        return node->left != NULL;
+    case NODE_ASSIGNMENT:
+        return node->left != NULL && node->var_name != NULL;
+    case NODE_VAR_DECLARATION:
+        return node->var_type != NULL && node->var_name != NULL;
+    case NODE_LITERAL:
+    case NODE_STRING_LITERAL:
+        return node->value != NULL;
+    default:
+        return true;
+    }
+}
+
+// This function maps the file, checks its header and rebuilds every node in one arena block
+bool cache_load(const char *dir, uint64_t key, Arena *arena, CachedProgram *program)
+{
+    char path[4096];
+    cache_path(path, sizeof(path), dir, key);
+
+    memset(program, 0, sizeof(*program));
+    if (!load_source_file(path, &program->file))
+    {
+        TRACE_INFO(TRACE_CACHE, "No cached program at %s", path);
+        return false;
+    }
+
+    const SourceFile *file = &program->file;
+    CacheHeader header;
+    bool ok = file->length >= sizeof(header);
+    if (ok)
+    {
+        memcpy(&header, file->data, sizeof(header));
+        ok = memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 && header.version == CACHE_FORMAT_VERSION &&
+             header.byte_order == CACHE_BYTE_ORDER && header.key == key && header.node_count > 0 &&
+             header.node_count <= (file->length - sizeof(header)) / sizeof(CachedNode) &&
+             header.string_bytes == file->length - sizeof(header) - header.node_count * sizeof(CachedNode) &&
+             header.string_bytes > 0 && file->data[file->length - 1] == '\0';
+    }
+    if (!ok)
+    {
+        TRACE_INFO(TRACE_CACHE, "Ignoring %s: wrong version or damaged", path);
+        release_cached_program(program);
+        return false;
+    }
+
+    // The records follow the 8-byte-aligned header, so they can be read in place
+    const CachedNode *records = (const CachedNode *)(file->data + sizeof(header));
+    const char *strings = file->data + sizeof(header) + header.node_count * sizeof(CachedNode);
+    ASTNode *nodes = (ASTNode *)arena_alloc(arena, header.node_count * sizeof(ASTNode));
+    for (size_t i = 0; i < header.node_count; i++)
+    {
+        if (!load_node(nodes, i, &records[i], &header, strings))
+        {
+            TRACE_INFO(TRACE_CACHE, "Ignoring %s: node %zu is malformed", path, i);
+            release_cached_program(program);
+            return false;
+        }
+    }
+
+    program->ast = &nodes[0];
+    program->slot_count = (size_t)header.slot_count;
+    TRACE_INFO(TRACE_CACHE, "Loaded %llu nodes from %s", (unsigned long long)header.node_count, path);
+    return true;
+}
+
+// This function unmaps (or frees) the cache file
+void release_cached_program(CachedProgram *program)
+{
+    if (program->file.data != NULL)
+    {
+        release_source_file(&program->file);
+    }
+    memset(program, 0, sizeof(*program));
+}
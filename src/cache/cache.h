@@ -0,0 +1,79 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "ast/ast.h"
+#include "common/arena.h"
+#include "common/source.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bumped whenever the file layout or the meaning of an AST field changes;
+// files written with another version are ignored and rewritten
+#define CACHE_FORMAT_VERSION 1
+
+// A program loaded from the cache
+typedef struct
+{
+    ASTNode *ast;      // The first statement; the nodes live in the caller's arena
+    size_t slot_count; // The number of variable slots the resolver assigned
+    SourceFile file;   // The cache file, which holds the program's strings; keep it until the AST is gone
+} CachedProgram;
+
+/**
+ * @brief Computes the cache key of a program.
+ *
+ * The key hashes the source text together with everything else that shapes
+ * the cached AST (the optimization level and the format version), so an
+ * edited script or a different -O level never finds a stale entry.
+ *
+ * @param source The program's source text.
+ * @param length The length of the source in bytes.
+ * @param opt_level The optimization level the AST was built with.
+ * @return uint64_t The key; also the name of the cache file.
+ */
+uint64_t cache_key(const char *source, size_t length, int opt_level);
+
+/**
+ * @brief Writes a checked and optimized program to the cache directory.
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * concurrent runs never see a partial file. The directory is created if it
+ * does not exist (its parent must).
+ *
+ * @param dir The cache directory.
+ * @param key The program's key from cache_key().
+ * @param ast The first statement of the program.
+ * @param slot_count The number of variable slots the resolver assigned.
+ * @return bool true if the file was written.
+ */
+bool cache_store(const char *dir, uint64_t key, const ASTNode *ast, size_t slot_count);
+
+/**
+ * @brief Loads a program from the cache directory, if it is there.
+ *
+ * The file is memory-mapped. All nodes are built with one allocation from
+ * 'arena' and refer to their names and string literals inside the mapping,
+ * so loading costs one pass over the nodes and no per-node allocation. A
+ * missing file, another format version or a truncated or malformed file is
+ * a miss. The type annotations are not checked again, so the cache directory
+ * must only hold files written by cache_store().
+ *
+ * @param dir The cache directory.
+ * @param key The program's key from cache_key().
+ * @param arena The arena that receives the nodes.
+ * @param program Receives the program on success.
+ * @return bool true on a hit.
+ */
+bool cache_load(const char *dir, uint64_t key, Arena *arena, CachedProgram *program);
+
+/**
+ * @brief Releases the cache file of a loaded program.
+ *
+ * The program's AST must no longer be used afterwards.
+ *
+ * @param program The program returned by cache_load().
+ */
+void release_cached_program(CachedProgram *program);
+
+#endif // CACHE_H
@@ -1,70 +1,307 @@
-// #include "codegen.h"
-// #include <stdio.h>
-
-// void generate_code(ASTNode *node)
-// {
-//     if (!node)
-//         return;
-
-//     switch (node->type)
-//     {
-//     case NODE_VAR_DECLARATION:
-//         printf("%s %s = ", node->var_type, node->var_name);
-//         generate_code(node->left);
-//         printf(";\n");
-//         break;
-
-//     case NODE_ASSIGNMENT:
-//         printf("%s = ", node->var_name);
-//         generate_code(node->left);
-//         printf(";\n");
-//         break;
-
-//     case NODE_BINARY_OP:
-//         generate_code(node->left);
-//         printf(" %s ", node->value);
-//         generate_code(node->right);
-//         break;
-
-//     case NODE_INT_LITERAL:
-//         printf("%d", node->int_value);
-//         break;
-
-//     case NODE_FLOAT_LITERAL:
-//         printf("%f", node->float_value);
-//         break;
-
-//     case NODE_LITERAL:
-//     case AST_NODE_LITERAL:
-//         printf("%s", node->value);
-//         break;
-
-//     case NODE_PRINT:
-//         printf("printf(\"%%d\\n\", ");
-//         generate_code(node->left);
-//         printf(");\n");
-//         break;
-
-//     case NODE_EXPRESSION:
-//         generate_code(node->left);
-//         break;
-
-//     case NODE_PROGRAM:
-//         // Handle program node if needed
-//         break;
-
-//     case NODE_NUMBER:
-//         // This case might be redundant if you're using INT_LITERAL and FLOAT_LITERAL
-//         printf("%s", node->value);
-//         break;
-
-//     default:
-//         printf("Unknown AST node type: %d\n", node->type);
-//         break;
-//     }
-
-//     if (node->next)
-//     {
-//         generate_code(node->next);
-//     }
-// }
+#include "codegen.h"
+#include "common/trace.h"
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// State carried through one translation
+typedef struct
+{
+    FILE *out;
+} CodeGenerator;
+
+// Support code placed at the top of every generated program. The arithmetic
+// helpers reproduce the execution engines exactly: they are int_add() to
+// int_mod() and int_pow() from src/common/intmath.h (keep them in sync), so
+// + - * wrap around and INT_MIN / -1 is INT_MIN instead of trapping.
+static const char *preamble =
+    "#include <limits.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <stdio.h>\n"
+    "\n"
+    "static inline int aplus_add(int a, int b) { return (int)((unsigned int)a + (unsigned int)b); }\n"
+    "static inline int aplus_sub(int a, int b) { return (int)((unsigned int)a - (unsigned int)b); }\n"
+    "static inline int aplus_mul(int a, int b) { return (int)((unsigned int)a * (unsigned int)b); }\n"
+    "\n"
+    "static inline int aplus_div(int a, int b)\n"
+    "{\n"
+    "    if (b == 0)\n"
+    "    {\n"
+    "        fputs(\"Error: Division by zero\\n\", stdout);\n"
+    "        return 0;\n"
+    "    }\n"
+    "    return b == -1 ? aplus_sub(0, a) : a / b;\n"
+    "}\n"
+    "\n"
+    "static inline int aplus_mod(int a, int b)\n"
+    "{\n"
+    "    if (b == 0)\n"
+    "    {\n"
+    "        fputs(\"Error: Modulus by zero\\n\", stdout);\n"
+    "        return 0;\n"
+    "    }\n"
+    "    return b == -1 ? 0 : a % b;\n"
+    "}\n"
+    "\n"
+    "static inline int aplus_pow(int base, int exponent)\n"
+    "{\n"
+    "    bool overflow = false;\n"
+    "    int acc = 1;\n"
+    "    if (exponent < 0)\n"
+    "    {\n"
+    "        overflow = base == 0;\n"
+    "        acc = base == 1 ? 1 : base == -1 ? ((exponent & 1) ? -1 : 1) : 0;\n"
+    "    }\n"
+    "    else if (exponent > 0)\n"
+    "    {\n"
+    "        for (;;)\n"
+    "        {\n"
+    "            overflow |= __builtin_mul_overflow(acc, (exponent & 1) ? base : 1, &acc);\n"
+    "            exponent >>= 1;\n"
+    "            if (exponent == 0)\n"
+    "                break;\n"
+    "            overflow |= __builtin_mul_overflow(base, base, &base);\n"
+    "        }\n"
+    "    }\n"
+    "    if (overflow)\n"
+    "    {\n"
+    "        fputs(\"Error: Integer overflow in '**'\\n\", stdout);\n"
+    "        return 0;\n"
+    "    }\n"
+    "    return acc;\n"
+    "}\n"
+    "\n";
+
+// Helper called for each operator, indexed by BinaryOperator
+static const char *operator_helpers[BINOP_COUNT] = {
+    [BINOP_ADD] = "aplus_add",
+    [BINOP_SUB] = "aplus_sub",
+    [BINOP_MUL] = "aplus_mul",
+    [BINOP_DIV] = "aplus_div",
+    [BINOP_MOD] = "aplus_mod",
+    [BINOP_POW] = "aplus_pow",
+};
+
+// This function writes a string as a C string literal, escaping every byte C could misread
+static void emit_string_literal(CodeGenerator *gen, const char *text, size_t length)
+{
+    fputc('"', gen->out);
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\' || c == '?') // '?' could start a trigraph
+            fprintf(gen->out, "\\%c", c);
+        else if (c >= 0x20 && c < 0x7f)
+            fputc(c, gen->out);
+        else
+            fprintf(gen->out, "\\%03o", c);
+    }
+    fputc('"', gen->out);
+}
+
+// This function writes the C name of the variable in 'slot'; the slot keeps shadowed names apart
+static void emit_variable(CodeGenerator *gen, int slot, const char *name)
+{
+    fprintf(gen->out, "v%d_%s", slot, name);
+}
+
+// This function writes an expression
+static void emit_expression(CodeGenerator *gen, ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_INT_LITERAL:
+        // INT_MIN has no literal form in C
+        if (node->int_value == INT_MIN)
+            fputs("INT_MIN", gen->out);
+        else
+            fprintf(gen->out, "%d", node->int_value);
+        break;
+    case NODE_BOOL_LITERAL:
+        fputs(node->bool_value ? "true" : "false", gen->out);
+        break;
+    case NODE_STRING_LITERAL:
+        emit_string_literal(gen, node->value, node->value_length);
+        break;
+    case NODE_LITERAL:
+        emit_variable(gen, node->slot, node->value);
+        break;
+    case NODE_BINARY_OP:
+        fprintf(gen->out, "%s(", operator_helpers[node->op]);
+        emit_expression(gen, node->left);
+        fputs(", ", gen->out);
+        emit_expression(gen, node->right);
+        fputc(')', gen->out);
+        break;
+    default:
+        break;
+    }
+}
+
+// This function writes one statement as a line of main()
+static void emit_statement(CodeGenerator *gen, ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_VAR_DECLARATION:
+    {
+        VariableType type = node->value_type;
+
+        fputs(type == STRING_TYPE ? "    const char *" : type == BOOL_TYPE ? "    bool " : "    int ", gen->out);
+        emit_variable(gen, node->slot, node->var_name);
+        fputs(" = ", gen->out);
+        if (node->left)
+            emit_expression(gen, node->left);
+        else
+            fputs(type == STRING_TYPE ? "\"\"" : type == BOOL_TYPE ? "false" : "0", gen->out);
+        fputs(";\n", gen->out);
+        break;
+    }
+    case NODE_ASSIGNMENT:
+        fputs("    ", gen->out);
+        emit_variable(gen, node->slot, node->var_name);
+        fputs(" = ", gen->out);
+        emit_expression(gen, node->left);
+        fputs(";\n", gen->out);
+        break;
+    case NODE_PRINT:
+    {
+        VariableType type = node->left->value_type;
+        if (type == BOOL_TYPE)
+        {
+            fputs("    fputs(", gen->out);
+            emit_expression(gen, node->left);
+            fputs(" ? \"true\\n\" : \"false\\n\", stdout);\n", gen->out);
+        }
+        else if (type == STRING_TYPE)
+        {
+            fputs("    puts(", gen->out);
+            emit_expression(gen, node->left);
+            fputs(");\n", gen->out);
+        }
+        else
+        {
+            fputs("    printf(\"%d\\n\", ", gen->out);
+            emit_expression(gen, node->left);
+            fputs(");\n", gen->out);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// This function translates the whole program
+bool generate_code(ASTNode *node, FILE *out)
+{
+    CodeGenerator gen;
+    gen.out = out;
+
+    fputs("/* Generated by a++c. */\n", out);
+    fputs(preamble, out);
+    fputs("int main(void)\n{\n", out);
+    for (; node != NULL; node = node->next)
+    {
+        emit_statement(&gen, node);
+    }
+    fputs("    return 0;\n}\n", out);
+    return ferror(out) == 0;
+}
+
+// This function pipes the generated C into the system compiler
+bool compile_to_executable(ASTNode *node, const char *output_path)
+{
+    // Generate into memory first, so the compiler is not started if generation fails
+    char *source = NULL;
+    size_t source_length = 0;
+    FILE *memory = open_memstream(&source, &source_length);
+    if (!memory)
+    {
+        printf("Error: Failed to allocate memory for the generated code.\n");
+        return false;
+    }
+    bool generated = generate_code(node, memory);
+    fclose(memory);
+    if (!generated)
+    {
+        free(source);
+        return false;
+    }
+
+    const char *cc = getenv("CC");
+    if (cc == NULL || *cc == '\0')
+    {
+        cc = "cc";
+    }
+    TRACE_INFO(TRACE_CODEGEN, "Compiling %zu bytes of C with %s", source_length, cc);
+
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        printf("Error: Could not start the C compiler: %s\n", strerror(errno));
+        free(source);
+        return false;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        printf("Error: Could not start the C compiler: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        free(source);
+        return false;
+    }
+    if (pid == 0)
+    {
+        // The compiler reads the translation unit from its standard input
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execlp(cc, cc, "-O2", "-x", "c", "-", "-o", output_path, (char *)NULL);
+        fprintf(stderr, "Error: Could not run '%s': %s\n", cc, strerror(errno));
+        _exit(127);
+    }
+
+    // A compiler that exits early must not kill us with SIGPIPE
+    close(fds[0]);
+    void (*previous)(int) = signal(SIGPIPE, SIG_IGN);
+    size_t written = 0;
+    while (written < source_length)
+    {
+        ssize_t n = write(fds[1], source + written, source_length - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        written += (size_t)n;
+    }
+    close(fds[1]);
+    signal(SIGPIPE, previous);
+    free(source);
+
+    int status = 0;
+    pid_t waited;
+    while ((waited = waitpid(pid, &status, 0)) < 0 && errno == EINTR)
+    {
+    }
+    if (waited < 0)
+    {
+        printf("Error: Could not wait for the C compiler building '%s'.\n", output_path);
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        printf("Error: The C compiler failed to build '%s'.\n", output_path);
+        return false;
+    }
+    return true;
+}
@@ -2,7 +2,37 @@
 #define CODEGEN_H
 
 #include "ast/ast.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 
-void generate_code(ASTNode *node);
+/**
+ * @brief Translates a resolved, type-checked program into a standalone C translation unit.
+ *
+ * The generated code has no dependencies beyond the C standard library and
+ * behaves like the execution engines: integer arithmetic wraps around,
+ * division by zero and overflowing powers print the same runtime errors,
+ * and print statements produce identical output. Every variable slot
+ * becomes a local of `main()`, declared with the C type matching the
+ * type checker's annotation.
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param out The stream that receives the C source.
+ * @return bool true on success, false if writing to the stream failed.
+ */
+bool generate_code(ASTNode *node, FILE *out);
+
+/**
+ * @brief Compiles a resolved, type-checked program to a native executable.
+ *
+ * The C source from generate_code() is piped into the system C compiler
+ * (the program named by the CC environment variable, or `cc`), which is
+ * run with optimization enabled.
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param output_path The path of the executable to create.
+ * @return bool true if the executable was built.
+ */
+bool compile_to_executable(ASTNode *node, const char *output_path);
 
 #endif // CODEGEN_H
@@ -0,0 +1,133 @@
+#include "arena.h"
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+// This function rounds 'size' up to the arena's alignment
+static size_t align_up(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+// This function adds a block big enough for at least 'size' bytes
+static ArenaBlock *add_block(Arena *arena, size_t size)
+{
+    // Blocks grow geometrically so large inputs need only a handful of them
+    size_t capacity = arena->block_size;
+    if (arena->head && arena->head->capacity * 2 > capacity)
+    {
+        capacity = arena->head->capacity * 2;
+    }
+    if (capacity < size)
+    {
+        capacity = size;
+    }
+
+    // Blocks are whole, aligned pages, so arena_freeze() can protect all of them
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t bytes = (sizeof(ArenaBlock) + capacity + page - 1) & ~(page - 1);
+    ArenaBlock *block = (ArenaBlock *)aligned_alloc(page, bytes);
+    if (!block)
+    {
+        printf("Error: Failed to allocate arena memory.\n");
+        exit(1);
+    }
+
+    block->next = arena->head;
+    block->capacity = bytes - sizeof(ArenaBlock);
+    block->used = 0;
+    arena->head = block;
+    return block;
+}
+
+// This function creates an arena; no memory is reserved until the first allocation
+Arena *create_arena(size_t block_size)
+{
+    Arena *arena = (Arena *)malloc(sizeof(Arena));
+    if (!arena)
+    {
+        printf("Error: Failed to allocate arena memory.\n");
+        exit(1);
+    }
+    arena->head = NULL;
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->frozen = false;
+    return arena;
+}
+
+// This function bumps the current block's pointer, adding a block when it is full
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = align_up(size ? size : 1);
+
+    ArenaBlock *block = arena->head;
+    if (!block || block->capacity - block->used < size)
+    {
+        block = add_block(arena, size);
+    }
+
+    void *memory = block->data + block->used;
+    block->used += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+// This function copies a NUL-terminated string into the arena
+char *arena_strdup(Arena *arena, const char *str)
+{
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// This function copies 'length' bytes into the arena and terminates them
+char *arena_strndup(Arena *arena, const char *str, size_t length)
+{
+    char *copy = (char *)arena_alloc(arena, length + 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// This function changes the protection of a block, header included
+static void protect_block(ArenaBlock *block, int protection)
+{
+    mprotect(block, sizeof(ArenaBlock) + block->capacity, protection);
+}
+
+// This function makes the arena's pages read-only
+void arena_freeze(Arena *arena)
+{
+    for (ArenaBlock *block = arena->head; block; block = block->next)
+    {
+        protect_block(block, PROT_READ);
+    }
+    arena->frozen = true;
+}
+
+// This function frees every block, then the arena
+void free_arena(Arena *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+
+    // free() writes its bookkeeping into the blocks, so frozen ones are unprotected first
+    ArenaBlock *block = arena->head;
+    while (block)
+    {
+        ArenaBlock *next = block->next;
+        if (arena->frozen)
+        {
+            protect_block(block, PROT_READ | PROT_WRITE);
+        }
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
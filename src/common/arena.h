@@ -0,0 +1,84 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// One contiguous block of arena memory; blocks form a singly linked list
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t capacity; // Usable bytes in 'data'
+    size_t used;     // Bytes handed out so far
+    alignas(max_align_t) unsigned char data[];
+} ArenaBlock;
+
+// A bump allocator: allocations are never freed individually, only all at once
+typedef struct
+{
+    ArenaBlock *head;  // The block allocations are currently served from
+    size_t block_size; // Minimum size of newly added blocks
+    bool frozen;       // arena_freeze() made the blocks read-only
+} Arena;
+
+/**
+ * @brief Creates a new, empty arena.
+ *
+ * @param block_size The minimum size of each block, or 0 for the default.
+ * @return Arena* A pointer to the newly created Arena.
+ */
+Arena *create_arena(size_t block_size);
+
+/**
+ * @brief Allocates zeroed memory from the arena.
+ *
+ * The memory is suitably aligned for any type and lives until the arena is freed.
+ *
+ * @param arena A pointer to the Arena.
+ * @param size The number of bytes to allocate.
+ * @return void* A pointer to the allocated memory.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a NUL-terminated string into the arena.
+ *
+ * @param arena A pointer to the Arena.
+ * @param str The string to copy.
+ * @return char* The arena-owned copy.
+ */
+char *arena_strdup(Arena *arena, const char *str);
+
+/**
+ * @brief Copies 'length' bytes into the arena and NUL-terminates the copy.
+ *
+ * @param arena A pointer to the Arena.
+ * @param str The bytes to copy (need not be NUL-terminated).
+ * @param length The number of bytes to copy.
+ * @return char* The arena-owned copy.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t length);
+
+/**
+ * @brief Makes everything allocated so far read-only.
+ *
+ * Every block of the arena is protected with mprotect(), so a
+ * stray write into a finished AST faults instead of silently dirtying pages
+ * shared copy-on-write with forked children. Nothing may be allocated from
+ * the arena afterwards. free_arena() makes the pages writable again.
+ *
+ * @param arena A pointer to the Arena.
+ */
+void arena_freeze(Arena *arena);
+
+/**
+ * @brief Releases every allocation made from the arena, and the arena itself.
+ *
+ * The cost depends only on the number of blocks, never on the number of allocations.
+ *
+ * @param arena A pointer to the Arena to be freed.
+ */
+void free_arena(Arena *arena);
+
+#endif // ARENA_H
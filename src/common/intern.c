@@ -0,0 +1,125 @@
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char INTERN_TYPE_INT[] = "int";
+const char INTERN_TYPE_FLOAT[] = "float";
+const char INTERN_TYPE_BOOL[] = "bool";
+const char INTERN_TYPE_STRING[] = "string";
+
+// FNV-1a hash of 'length' bytes
+static uint32_t hash_bytes(const char *str, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// This function finds the bucket that holds the string, or the empty bucket where it belongs
+static InternEntry *find_entry(InternEntry *entries, size_t capacity, const char *str, size_t length, uint32_t hash)
+{
+    size_t mask = capacity - 1;
+    size_t index = hash & mask;
+    while (entries[index].string != NULL &&
+           (entries[index].hash != hash || entries[index].length != length ||
+            memcmp(entries[index].string, str, length) != 0))
+    {
+        index = (index + 1) & mask;
+    }
+    return &entries[index];
+}
+
+// This function doubles the hash table and re-inserts every string
+static void grow_entries(InternTable *table)
+{
+    size_t capacity = table->capacity ? table->capacity * 2 : 256;
+    InternEntry *entries = (InternEntry *)calloc(capacity, sizeof(InternEntry));
+    if (!entries)
+    {
+        printf("Error: Failed to allocate memory for the string table.\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        InternEntry *entry = &table->entries[i];
+        if (entry->string != NULL)
+        {
+            *find_entry(entries, capacity, entry->string, entry->length, entry->hash) = *entry;
+        }
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+// This function adds a string the table does not hold yet, without copying it
+static void insert_static(InternTable *table, const char *str)
+{
+    size_t length = strlen(str);
+    uint32_t hash = hash_bytes(str, length);
+    InternEntry *entry = find_entry(table->entries, table->capacity, str, length, hash);
+    entry->string = str;
+    entry->length = length;
+    entry->hash = hash;
+    table->count++;
+}
+
+// This function creates a table holding only the built-in type names
+InternTable *create_intern_table(Arena *arena)
+{
+    InternTable *table = (InternTable *)calloc(1, sizeof(InternTable));
+    if (!table)
+    {
+        printf("Error: Failed to allocate memory for the string table.\n");
+        exit(1);
+    }
+    table->arena = arena;
+    grow_entries(table);
+
+    insert_static(table, INTERN_TYPE_INT);
+    insert_static(table, INTERN_TYPE_FLOAT);
+    insert_static(table, INTERN_TYPE_BOOL);
+    insert_static(table, INTERN_TYPE_STRING);
+    return table;
+}
+
+// This function returns the table's copy of the string, copying it into the arena the first time
+const char *intern_string(InternTable *table, const char *str, size_t length)
+{
+    uint32_t hash = hash_bytes(str, length);
+    InternEntry *entry = find_entry(table->entries, table->capacity, str, length, hash);
+    if (entry->string != NULL)
+    {
+        return entry->string;
+    }
+
+    // Keep the load factor under 3/4 so probe sequences stay short
+    if ((table->count + 1) * 4 > table->capacity * 3)
+    {
+        grow_entries(table);
+        entry = find_entry(table->entries, table->capacity, str, length, hash);
+    }
+
+    entry->string = arena_strndup(table->arena, str, length);
+    entry->length = length;
+    entry->hash = hash;
+    table->count++;
+    return entry->string;
+}
+
+// This function frees the table; the strings stay in the arena
+void free_intern_table(InternTable *table)
+{
+    if (table)
+    {
+        free(table->entries);
+        free(table);
+    }
+}
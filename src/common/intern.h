@@ -0,0 +1,62 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "arena.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// One entry of the intern hash table
+typedef struct
+{
+    const char *string; // NULL marks an empty bucket
+    size_t length;
+    uint32_t hash;
+} InternEntry;
+
+// Stores each distinct string once, so interned strings can be compared by pointer
+typedef struct
+{
+    Arena *arena;         // Owns the string bytes
+    InternEntry *entries; // Open-addressed table
+    size_t capacity;      // Always a power of two
+    size_t count;
+} InternTable;
+
+// The built-in type names. Every table starts out holding these exact
+// pointers, so an interned type name can be compared against them directly.
+extern const char INTERN_TYPE_INT[];
+extern const char INTERN_TYPE_FLOAT[];
+extern const char INTERN_TYPE_BOOL[];
+extern const char INTERN_TYPE_STRING[];
+
+/**
+ * @brief Creates an intern table whose strings are copied into an arena.
+ *
+ * @param arena The arena that owns the interned strings; it must outlive every use of them.
+ * @return InternTable* A pointer to the newly created InternTable.
+ */
+InternTable *create_intern_table(Arena *arena);
+
+/**
+ * @brief Returns the unique copy of a string, adding it on first use.
+ *
+ * Interning the same bytes twice returns the same pointer. The result is
+ * NUL-terminated.
+ *
+ * @param table A pointer to the InternTable.
+ * @param str The bytes to intern (need not be NUL-terminated).
+ * @param length The number of bytes.
+ * @return const char* The interned string.
+ */
+const char *intern_string(InternTable *table, const char *str, size_t length);
+
+/**
+ * @brief Frees the hash table.
+ *
+ * The strings belong to the arena and stay valid until it is freed.
+ *
+ * @param table A pointer to the InternTable to be freed.
+ */
+void free_intern_table(InternTable *table);
+
+#endif // INTERN_H
@@ -0,0 +1,116 @@
+#ifndef INTMATH_H
+#define INTMATH_H
+
+#include <limits.h>
+#include <stdbool.h>
+
+// The arithmetic of the '+', '-', '*', '/' and '%' operators, shared by the
+// optimizer and every execution engine so they all compute the same results.
+// Overflow wraps around in two's complement instead of being undefined, and
+// INT_MIN / -1 is INT_MIN (INT_MIN % -1 is 0) instead of trapping. Division
+// and modulus by zero are the caller's to report; the divisor must not be 0.
+
+static inline int int_add(int a, int b)
+{
+    return (int)((unsigned int)a + (unsigned int)b);
+}
+
+static inline int int_sub(int a, int b)
+{
+    return (int)((unsigned int)a - (unsigned int)b);
+}
+
+static inline int int_mul(int a, int b)
+{
+    return (int)((unsigned int)a * (unsigned int)b);
+}
+
+static inline int int_div(int a, int b)
+{
+    return b == -1 ? int_sub(0, a) : a / b;
+}
+
+static inline int int_mod(int a, int b)
+{
+    return b == -1 ? 0 : a % b;
+}
+
+/**
+ * @brief Multiplies two ints, detecting overflow.
+ *
+ * @param a The first factor.
+ * @param b The second factor.
+ * @param result Receives the product (wrapped around if it overflowed).
+ * @return bool true if the product does not fit in an int.
+ */
+static inline bool int_mul_overflow(int a, int b, int *result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, result);
+#else
+    long long product = (long long)a * b;
+    *result = (int)(unsigned int)product;
+    return product > INT_MAX || product < INT_MIN;
+#endif
+}
+
+/**
+ * @brief Computes base ** exponent exactly, by squaring, without going through double.
+ *
+ * This is what the '**' operator means in every execution engine. A negative
+ * exponent truncates toward zero, so only 1 and -1 give a non-zero result.
+ * Small exponents (0 to 2) take a direct path, which is what constant
+ * exponents in source code almost always are.
+ *
+ * @param base The base.
+ * @param exponent The exponent.
+ * @param result Receives the power (wrapped around if it overflowed).
+ * @return bool false if the result does not fit in an int (or is 0 ** negative).
+ */
+static inline bool int_pow(int base, int exponent, int *result)
+{
+    switch (exponent)
+    {
+    case 0:
+        *result = 1;
+        return true;
+    case 1:
+        *result = base;
+        return true;
+    case 2:
+        return !int_mul_overflow(base, base, result);
+    default:
+        break;
+    }
+
+    if (exponent < 0)
+    {
+        if (base == 0)
+        {
+            return false;
+        }
+        *result = base == 1 ? 1 : base == -1 ? ((exponent & 1) ? -1 : 1) : 0;
+        return true;
+    }
+
+    // Square the base once per exponent bit; it is only squared while bits remain,
+    // so an overflow there always means the result overflows too. Overflow is
+    // accumulated rather than branched on, which keeps the loop free of
+    // data-dependent branches apart from its trip count.
+    bool overflow = false;
+    int acc = 1;
+    for (;;)
+    {
+        overflow |= int_mul_overflow(acc, (exponent & 1) ? base : 1, &acc);
+        exponent >>= 1;
+        if (exponent == 0)
+        {
+            break;
+        }
+        overflow |= int_mul_overflow(base, base, &base);
+    }
+    *result = acc;
+    return !overflow;
+}
+
+#endif // INTMATH_H
@@ -0,0 +1,164 @@
+#include "pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// The tasks a worker still has to run: [next, end). The owner takes from the
+// front; thieves take from the back, so they rarely touch the owner's next task.
+typedef struct
+{
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} PoolQueue;
+
+typedef struct
+{
+    PoolQueue *queues;
+    int thread_count;
+    PoolTask task;
+    void *context;
+} Pool;
+
+// What each thread is started with
+typedef struct
+{
+    Pool *pool;
+    int worker;
+} PoolWorker;
+
+// This function takes the worker's next task, if it has one left
+static bool take_task(PoolQueue *queue, size_t *index)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->next < queue->end;
+    if (found)
+    {
+        *index = queue->next++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+// This function moves the back half of the fullest other queue into the worker's own queue
+static bool steal_tasks(Pool *pool, int worker)
+{
+    // Pick the victim without locking; the count is checked again under its lock
+    int victim = -1;
+    size_t most = 0;
+    for (int i = 1; i < pool->thread_count; i++)
+    {
+        int candidate = (worker + i) % pool->thread_count;
+        PoolQueue *queue = &pool->queues[candidate];
+        pthread_mutex_lock(&queue->lock);
+        size_t left = queue->end - queue->next;
+        pthread_mutex_unlock(&queue->lock);
+        if (left > most)
+        {
+            most = left;
+            victim = candidate;
+        }
+    }
+    if (victim < 0)
+    {
+        return false;
+    }
+
+    PoolQueue *from = &pool->queues[victim];
+    pthread_mutex_lock(&from->lock);
+    size_t left = from->end - from->next;
+    size_t taken = left - left / 2; // The larger half, so a single task left can be stolen too
+    size_t end = from->end;
+    from->end -= taken;
+    pthread_mutex_unlock(&from->lock);
+    if (taken == 0)
+    {
+        return true; // Someone else emptied it first; look again
+    }
+
+    PoolQueue *own = &pool->queues[worker];
+    pthread_mutex_lock(&own->lock);
+    own->next = end - taken;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    return true;
+}
+
+// This function runs tasks until no queue has any left
+static void *run_worker(void *argument)
+{
+    PoolWorker *self = (PoolWorker *)argument;
+    Pool *pool = self->pool;
+    size_t index;
+    for (;;)
+    {
+        while (take_task(&pool->queues[self->worker], &index))
+        {
+            pool->task(pool->context, index, self->worker);
+        }
+        if (!steal_tasks(pool, self->worker))
+        {
+            return NULL;
+        }
+    }
+}
+
+// This function splits the tasks evenly, runs one worker per thread and waits for them
+bool run_pool(size_t task_count, int thread_count, PoolTask task, void *context)
+{
+    if (thread_count < 1)
+    {
+        thread_count = 1;
+    }
+    if ((size_t)thread_count > task_count)
+    {
+        thread_count = task_count > 0 ? (int)task_count : 1;
+    }
+
+    Pool pool = {NULL, thread_count, task, context};
+    pool.queues = (PoolQueue *)calloc((size_t)thread_count, sizeof(PoolQueue));
+    PoolWorker *workers = (PoolWorker *)calloc((size_t)thread_count, sizeof(PoolWorker));
+    pthread_t *threads = (pthread_t *)calloc((size_t)thread_count, sizeof(pthread_t));
+    if (!pool.queues || !workers || !threads)
+    {
+        printf("Error: Failed to allocate memory for the thread pool.\n");
+        free(pool.queues);
+        free(workers);
+        free(threads);
+        return false;
+    }
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+        pool.queues[i].next = task_count * (size_t)i / (size_t)thread_count;
+        pool.queues[i].end = task_count * (size_t)(i + 1) / (size_t)thread_count;
+        workers[i] = (PoolWorker){&pool, i};
+    }
+
+    // Worker 0 is the calling thread; a thread that cannot be started leaves its share to be stolen
+    for (int i = 1; i < thread_count; i++)
+    {
+        if (pthread_create(&threads[i], NULL, run_worker, &workers[i]) != 0)
+        {
+            workers[i].pool = NULL;
+        }
+    }
+    run_worker(&workers[0]);
+    for (int i = 1; i < thread_count; i++)
+    {
+        if (workers[i].pool != NULL)
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+    free(pool.queues);
+    free(workers);
+    free(threads);
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// One task of a parallel run: 'index' is the task's number, 'worker' the thread (0 to thread_count - 1) running it
+typedef void (*PoolTask)(void *context, size_t index, int worker);
+
+/**
+ * @brief Runs tasks 0 to task_count - 1 on a pool of threads and waits for all of them.
+ *
+ * Each thread starts with a contiguous share of the tasks and works through
+ * it in order. A thread that runs out steals the second half of the largest
+ * share left, so uneven tasks keep every thread busy without a central queue.
+ * The calling thread is one of the workers.
+ *
+ * @param task_count The number of tasks.
+ * @param thread_count The number of threads to use (at least 1; no more than task_count are started).
+ * @param task The function that runs one task; it must be safe to call from several threads.
+ * @param context Passed to every call of 'task'.
+ * @return bool true if every task ran, false if the threads could not be started.
+ */
+bool run_pool(size_t task_count, int thread_count, PoolTask task, void *context);
+
+#endif // POOL_H
@@ -0,0 +1,33 @@
+#include "report.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+// Each thread has its own destination, so programs built on different threads never mix their messages
+static _Thread_local Output *report_output = NULL;
+
+// This function sets where the calling thread's messages go
+void set_report_output(Output *out)
+{
+    report_output = out;
+}
+
+// This function formats a message and writes it to the thread's destination
+void report(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    if (report_output == NULL)
+    {
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+
+    char message[1024];
+    int length = vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    if (length > 0)
+    {
+        output_write(report_output, message, (size_t)length < sizeof(message) ? (size_t)length : sizeof(message) - 1);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "runtime/output.h"
+
+/**
+ * @brief Prints a message about the program being built (printf-style).
+ *
+ * Errors and warnings found before a program runs, from the lexer to the
+ * optimizer, go through here. They are printed on stdout, like the rest of
+ * the driver's messages, unless the calling thread has sent them elsewhere
+ * with set_report_output(). That way each of several programs built at once
+ * can keep its messages together with its own output.
+ *
+ * @param format The printf format of the message, usually ending in "\n".
+ */
+void report(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Sends the calling thread's report() messages to a writer.
+ *
+ * @param out The writer that receives them, or NULL for stdout again.
+ */
+void set_report_output(Output *out);
+
+#endif // REPORT_H
@@ -0,0 +1,107 @@
+#include "source.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// This function reads everything left on 'fd' into a growing heap buffer
+static bool read_all(int fd, SourceFile *source)
+{
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *buffer = (char *)malloc(capacity);
+    if (!buffer)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        if (length == capacity)
+        {
+            capacity *= 2;
+            char *grown = (char *)realloc(buffer, capacity);
+            if (!grown)
+            {
+                free(buffer);
+                return false;
+            }
+            buffer = grown;
+        }
+
+        ssize_t n = read(fd, buffer + length, capacity - length);
+        if (n < 0)
+        {
+            free(buffer);
+            return false;
+        }
+        if (n == 0)
+        {
+            break; // End of file
+        }
+        length += (size_t)n;
+    }
+
+    source->data = buffer;
+    source->length = length;
+    source->mapped = false;
+    return true;
+}
+
+// This function maps regular files and falls back to reading everything else
+bool load_source_file(const char *path, SourceFile *source)
+{
+    bool from_stdin = strcmp(path, "-") == 0;
+    int fd = from_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    bool ok = false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            // The lexer reads front to back, so let the kernel read ahead aggressively
+            madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+            source->data = (const char *)data;
+            source->length = (size_t)info.st_size;
+            source->mapped = true;
+            ok = true;
+        }
+    }
+
+    // Pipes, terminals, empty files and anything mmap refused are read instead
+    if (!ok)
+    {
+        ok = read_all(fd, source);
+    }
+
+    if (!from_stdin)
+    {
+        close(fd); // The mapping stays valid after the descriptor is closed
+    }
+    return ok;
+}
+
+// This function unmaps or frees the file's contents
+void release_source_file(SourceFile *source)
+{
+    if (source->mapped)
+    {
+        munmap((void *)source->data, source->length);
+    }
+    else
+    {
+        free((void *)source->data);
+    }
+    source->data = NULL;
+    source->length = 0;
+    source->mapped = false;
+}
@@ -0,0 +1,35 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The contents of a source file, either mapped straight from the page cache or read into memory
+typedef struct
+{
+    const char *data; // The file's bytes; not NUL-terminated when mapped
+    size_t length;    // Number of bytes in 'data'
+    bool mapped;      // true if 'data' is an mmap of the file, false if it was read into the heap
+} SourceFile;
+
+/**
+ * @brief Loads a source file for lexing.
+ *
+ * Regular files are memory-mapped read-only so the lexer scans the page
+ * cache directly. Pipes, terminals and other files that cannot be mapped
+ * are read into a heap buffer instead. A path of "-" reads standard input.
+ *
+ * @param path The path of the file to load, or "-" for standard input.
+ * @param source Receives the loaded contents.
+ * @return bool true on success, false if the file could not be opened or read.
+ */
+bool load_source_file(const char *path, SourceFile *source);
+
+/**
+ * @brief Releases a source file loaded with load_source_file().
+ *
+ * @param source A pointer to the SourceFile to release.
+ */
+void release_source_file(SourceFile *source);
+
+#endif // SOURCE_H
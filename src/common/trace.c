@@ -0,0 +1,138 @@
+#include "trace.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_BUFFER_SIZE (256 * 1024)
+
+unsigned int trace_categories = 0;
+TraceLevel trace_level = TRACE_LEVEL_DEBUG;
+
+static FILE *trace_sink = NULL;
+static char *trace_buffer = NULL;
+
+// Category names, in bit order
+static const char *category_names[] = {"lexer", "parser", "resolver", "interpreter", "vm", "optimizer", "codegen", "jit", "cache"};
+static const char *level_names[] = {"error", "warn", "info", "debug"};
+
+#define CATEGORY_COUNT (sizeof(category_names) / sizeof(category_names[0]))
+
+// This function parses a comma-separated category list into a bit mask
+static bool parse_categories(const char *list, unsigned int *mask)
+{
+    *mask = 0;
+    while (*list)
+    {
+        size_t length = strcspn(list, ",");
+        if (length == 3 && strncmp(list, "all", 3) == 0)
+        {
+            *mask |= TRACE_ALL;
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < CATEGORY_COUNT; i++)
+            {
+                if (strlen(category_names[i]) == length && strncmp(list, category_names[i], length) == 0)
+                {
+                    *mask |= 1u << i;
+                    break;
+                }
+            }
+            if (i == CATEGORY_COUNT)
+            {
+                return false;
+            }
+        }
+        list += length;
+        if (*list == ',')
+        {
+            list++;
+        }
+    }
+    return true;
+}
+
+bool trace_parse_level(const char *name, TraceLevel *level)
+{
+    for (int i = TRACE_LEVEL_ERROR; i <= TRACE_LEVEL_DEBUG; i++)
+    {
+        if (strcmp(name, level_names[i]) == 0)
+        {
+            *level = (TraceLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool trace_configure(const char *categories, TraceLevel level, const char *path)
+{
+    unsigned int mask;
+    if (!parse_categories(categories, &mask))
+    {
+        return false;
+    }
+
+    trace_close();
+    // stderr gets its own FILE so the large buffer below never changes how stderr itself behaves
+    trace_sink = path ? fopen(path, "w") : fdopen(dup(STDERR_FILENO), "w");
+    if (!trace_sink)
+    {
+        return false;
+    }
+
+    // A large, fully buffered sink keeps tracing from turning every message into a write()
+    trace_buffer = (char *)malloc(TRACE_BUFFER_SIZE);
+    if (trace_buffer)
+    {
+        setvbuf(trace_sink, trace_buffer, _IOFBF, TRACE_BUFFER_SIZE);
+    }
+
+    trace_categories = mask;
+    trace_level = level;
+
+    static bool registered = false;
+    if (!registered)
+    {
+        atexit(trace_close);
+        registered = true;
+    }
+    return true;
+}
+
+void trace_write(TraceCategory category, TraceLevel level, const char *format, ...)
+{
+    if (!trace_sink)
+    {
+        return;
+    }
+
+    // The category's bit index gives its name
+    unsigned int index = 0;
+    while (index < CATEGORY_COUNT && !((unsigned int)category & (1u << index)))
+    {
+        index++;
+    }
+
+    fprintf(trace_sink, "[%s] %s: ", index < CATEGORY_COUNT ? category_names[index] : "?", level_names[level]);
+    va_list args;
+    va_start(args, format);
+    vfprintf(trace_sink, format, args);
+    va_end(args);
+    fputc('\n', trace_sink);
+}
+
+void trace_close(void)
+{
+    if (trace_sink)
+    {
+        fclose(trace_sink); // Flushes anything still buffered
+        trace_sink = NULL;
+    }
+    free(trace_buffer);
+    trace_buffer = NULL;
+    trace_categories = 0;
+}
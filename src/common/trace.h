@@ -0,0 +1,102 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+// Tracing is compiled in only for debug builds ('make debug' defines DEBUG).
+// In every other build the TRACE macros expand to dead code that the
+// compiler removes entirely, so hot paths pay nothing for them.
+#ifdef DEBUG
+#define TRACE_ENABLED 1
+#else
+#define TRACE_ENABLED 0
+#endif
+
+// How detailed a trace message is; a message is written if its level is at or below the configured one
+typedef enum
+{
+    TRACE_LEVEL_ERROR,
+    TRACE_LEVEL_WARN,
+    TRACE_LEVEL_INFO,
+    TRACE_LEVEL_DEBUG
+} TraceLevel;
+
+// Which part of the pipeline a message comes from (a bit mask, so several can be enabled)
+typedef enum
+{
+    TRACE_LEXER = 1 << 0,
+    TRACE_PARSER = 1 << 1,
+    TRACE_RESOLVER = 1 << 2,
+    TRACE_INTERPRETER = 1 << 3,
+    TRACE_VM = 1 << 4,
+    TRACE_OPTIMIZER = 1 << 5,
+    TRACE_CODEGEN = 1 << 6,
+    TRACE_JIT = 1 << 7,
+    TRACE_CACHE = 1 << 8,
+    TRACE_ALL = (1 << 9) - 1
+} TraceCategory;
+
+// The active configuration, read by the TRACE macro
+extern unsigned int trace_categories;
+extern TraceLevel trace_level;
+
+/**
+ * @brief Enables tracing for the given categories and level.
+ *
+ * Messages go to a buffered sink that is separate from program output: the
+ * file at 'path', or stderr if 'path' is NULL. The sink is flushed at exit.
+ *
+ * @param categories A comma-separated list of category names ("lexer",
+ *                   "parser", "resolver", "interpreter", "vm",
+ *                   "optimizer", "codegen", "jit", "cache") or "all".
+ * @param level The most detailed level to write.
+ * @param path The file to write to, or NULL for stderr.
+ * @return bool true on success, false if a category is unknown or the file cannot be opened.
+ */
+bool trace_configure(const char *categories, TraceLevel level, const char *path);
+
+/**
+ * @brief Parses a level name ("error", "warn", "info" or "debug").
+ *
+ * @param name The level name.
+ * @param level Receives the parsed level.
+ * @return bool true if the name is known.
+ */
+bool trace_parse_level(const char *name, TraceLevel *level);
+
+/**
+ * @brief Writes one trace message to the sink. Use the TRACE macro instead.
+ *
+ * @param category The category of the message.
+ * @param level The level of the message.
+ * @param format A printf-style format string.
+ */
+void trace_write(TraceCategory category, TraceLevel level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Flushes and closes the trace sink.
+ */
+void trace_close(void);
+
+#if TRACE_ENABLED
+#define TRACE(category, level, ...)                                         \
+    do                                                                      \
+    {                                                                       \
+        if ((trace_categories & (category)) && (level) <= trace_level)      \
+            trace_write((category), (level), __VA_ARGS__);                  \
+    } while (0)
+#else
+// Still type-checks the arguments, but generates no code
+#define TRACE(category, level, ...)                                         \
+    do                                                                      \
+    {                                                                       \
+        if (0)                                                              \
+            trace_write((category), (level), __VA_ARGS__);                  \
+    } while (0)
+#endif
+
+#define TRACE_DEBUG(category, ...) TRACE(category, TRACE_LEVEL_DEBUG, __VA_ARGS__)
+#define TRACE_INFO(category, ...) TRACE(category, TRACE_LEVEL_INFO, __VA_ARGS__)
+
+#endif // TRACE_H
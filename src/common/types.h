@@ -1,6 +1,8 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stdbool.h>
+
 typedef enum {
     INT_TYPE,
     FLOAT_TYPE,
@@ -8,4 +10,13 @@ typedef enum {
     BOOL_TYPE
 } VariableType;
 
+// A runtime value: a VM register or constant, or the value of a program parameter.
+// The type checker knows the static type of every value, so values carry no tag.
+typedef union
+{
+    int int_value;
+    bool bool_value;
+    const char *string_value;
+} Value;
+
 #endif // TYPES_H
@@ -0,0 +1,268 @@
+#include "core.h"
+#include "common/report.h"
+#include "common/source.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "semantic/resolver.h"
+#include "semantic/typecheck.h"
+#include "vm/compiler.h"
+#include "vm/vm.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// This function runs the front end and the optimizer over a source, building the AST in 'program->arena'.
+// 'clean' is set if no statement was rejected, so the AST is the whole program.
+static bool build_ast(Program *program, const char *source, size_t length, int opt_level, bool *clean)
+{
+    // Initialize the lexer over the source bytes (they are not NUL-terminated when mapped)
+    Lexer *lexer = init_lexer_n(source, length);
+
+    // Create a parser using the lexer; the arena owns the whole AST
+    Parser *parser = create_parser(lexer, program->arena);
+
+    // Parse the tokens to create an Abstract Syntax Tree (AST)
+    ASTNode *ast = parse_tokens(parser);
+
+    // Bind every variable reference to a numeric slot, annotate every expression
+    // with its type (reporting type errors before anything runs), then fold
+    // constants and simplify expressions before any engine sees the tree
+    SymbolTable *symbols = NULL;
+    const char *failure = NULL;
+    if (ast == NULL)
+    {
+        failure = "Error: Failed to parse the source file.\n";
+    }
+    else
+    {
+        symbols = create_symbol_table();
+        if (!resolve_program(symbols, ast))
+        {
+            failure = "Error: Failed to resolve the source file.\n";
+        }
+        else if (!typecheck_program(ast, symbols->slot_count) || !optimize_program(ast, opt_level))
+        {
+            failure = "Error: Failed to compile the source file.\n";
+        }
+    }
+
+    if (failure != NULL)
+    {
+        report("%s", failure);
+    }
+    else
+    {
+        program->ast = ast;
+        program->slot_count = symbols->slot_count;
+        *clean = !parser->had_error;
+    }
+
+    // The AST keeps only interned strings and arena nodes, so the front end can go
+    free_symbol_table(symbols);
+    free_parser(parser);
+    free(lexer);
+    return failure == NULL;
+}
+
+// This function builds a program, or loads it from the cache when it was built before
+Program *build_program(const char *source, size_t length, const BuildOptions *options)
+{
+    Program *program = (Program *)calloc(1, sizeof(Program));
+    if (!program)
+    {
+        report("Error: Failed to allocate memory for the program.\n");
+        return NULL;
+    }
+    program->arena = create_arena(0);
+
+    // An unchanged script that was checked before skips straight to execution
+    uint64_t key = 0;
+    if (options->cache_dir != NULL)
+    {
+        key = cache_key(source, length, options->opt_level);
+        if (cache_load(options->cache_dir, key, program->arena, &program->cached))
+        {
+            program->ast = program->cached.ast;
+            program->slot_count = program->cached.slot_count;
+            return program;
+        }
+    }
+
+    bool clean = false;
+    if (!build_ast(program, source, length, options->opt_level, &clean))
+    {
+        free_program(program);
+        return NULL;
+    }
+
+    // Programs with rejected statements print their parse errors on every
+    // run, so only programs that were accepted whole are worth caching
+    if (options->cache_dir != NULL && clean)
+    {
+        cache_store(options->cache_dir, key, program->ast, program->slot_count);
+    }
+    return program;
+}
+
+// This function loads a source file and builds the program in it
+Program *load_program(const char *filename, const BuildOptions *options)
+{
+    // Map the file (or read it, for pipes and stdin) so the lexer can scan it in place
+    SourceFile source;
+    if (!load_source_file(filename, &source))
+    {
+        report("Error: Could not open file '%s'.\n", filename);
+        return NULL;
+    }
+
+    // The AST does not point into the source, so it can be released right away
+    Program *program = build_program(source.data, source.length, options);
+    release_source_file(&source);
+    return program;
+}
+
+// This function frees a program's nodes and releases its cache file
+void free_program(Program *program)
+{
+    if (program)
+    {
+        free_arena(program->arena);
+        release_cached_program(&program->cached);
+        free(program);
+    }
+}
+
+// This function protects a program's nodes against writes
+void freeze_program(Program *program)
+{
+    arena_freeze(program->arena);
+}
+
+// This function compiles a program for an engine, once for all of the context's runs
+Context *create_context(const Program *program, ExecutionEngine engine)
+{
+    Context *context = (Context *)calloc(1, sizeof(Context));
+    if (!context)
+    {
+        report("Error: Failed to allocate memory for the context.\n");
+        return NULL;
+    }
+    context->program = program;
+    context->engine = engine;
+
+    if (engine == ENGINE_TREE || engine == ENGINE_JIT)
+    {
+        context->interpreter = create_interpreter(program->ast, program->slot_count, engine == ENGINE_JIT);
+    }
+    else
+    {
+        // Lower the AST to bytecode for the VM
+        context->chunk = compile_to_bytecode(program->ast, program->slot_count);
+        if (context->chunk == NULL)
+        {
+            report("Error: Failed to compile the source file.\n");
+        }
+    }
+
+    if (context->interpreter == NULL && context->chunk == NULL)
+    {
+        free(context);
+        return NULL;
+    }
+    return context;
+}
+
+// This function reads a parameter value as the declared type; strings are taken as they are
+static bool parse_parameter(VariableType type, const char *text, Value *value)
+{
+    switch (type)
+    {
+    case INT_TYPE:
+    {
+        char *end;
+        errno = 0;
+        long number = strtol(text, &end, 10);
+        if (end == text || *end != '\0' || errno != 0 || number < INT_MIN || number > INT_MAX)
+        {
+            return false;
+        }
+        value->int_value = (int)number;
+        return true;
+    }
+    case BOOL_TYPE:
+        value->bool_value = strcmp(text, "true") == 0;
+        return value->bool_value || strcmp(text, "false") == 0;
+    case STRING_TYPE:
+        value->string_value = text;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// This function gives every declaration of 'name' without a value its starting value
+bool set_context_parameter(Context *context, const char *name, const char *value)
+{
+    bool found = false;
+    for (const ASTNode *node = context->program->ast; node != NULL; node = node->next)
+    {
+        if (node->type != NODE_VAR_DECLARATION || node->left != NULL || strcmp(node->var_name, name) != 0)
+        {
+            continue;
+        }
+
+        Value parsed;
+        if (!parse_parameter(node->value_type, value, &parsed))
+        {
+            report("Error: Parameter '%s' is %s, not '%s'.\n", name, node->value_type == BOOL_TYPE ? "a bool" : "an int",
+                   value);
+            return false;
+        }
+        found = true;
+
+        if (context->interpreter != NULL)
+        {
+            set_interpreter_parameter(context->interpreter, (size_t)node->slot, node->value_type, parsed);
+            continue;
+        }
+        // The VM loads the declaration's register from a constant of its own
+        Chunk *chunk = context->chunk;
+        for (size_t i = 0; i < chunk->parameter_count; i++)
+        {
+            if (chunk->parameters[i].slot == (uint32_t)node->slot)
+            {
+                set_constant(chunk, chunk->parameters[i].constant, parsed);
+            }
+        }
+    }
+
+    if (!found)
+    {
+        report("Error: The program has no parameter '%s' (declare it without a value, as in 'int %s;').\n", name, name);
+    }
+    return found;
+}
+
+// This function runs a program on the engine its context was created for
+bool run_context(Context *context, Output *out)
+{
+    if (context->interpreter != NULL)
+    {
+        run_interpreter(context->interpreter, out);
+        return true;
+    }
+    return run_bytecode(context->chunk, out) == 0;
+}
+
+// This function frees a context's bytecode or interpreter; the program stays
+void free_context(Context *context)
+{
+    if (context)
+    {
+        free_interpreter(context->interpreter);
+        free_chunk(context->chunk);
+        free(context);
+    }
+}
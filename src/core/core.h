@@ -0,0 +1,141 @@
+#ifndef CORE_H
+#define CORE_H
+
+// The library interface of A++ (build/lib/libaplusplus.a). A program is built
+// once into a Program, which is read-only from then on, and run through any
+// number of Contexts. Each Context owns all the state of running it, so a
+// Program can run many times in a row, and several Contexts (one per thread)
+// can run the same or different programs at the same time. Tracing (debug
+// builds) writes to one shared sink, so keep it off when running on threads.
+
+#include "ast/ast.h"
+#include "cache/cache.h"
+#include "common/arena.h"
+#include "interpreter/interpreter.h"
+#include "optimizer/optimizer.h"
+#include "runtime/output.h"
+#include "vm/bytecode.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// The execution engines that can run a program
+typedef enum
+{
+    ENGINE_VM,   // Compile to bytecode and run it on the register VM (default)
+    ENGINE_TREE, // Walk the AST directly (reference implementation)
+    ENGINE_JIT   // Walk the AST, running integer arithmetic as native code
+} ExecutionEngine;
+
+// Settings that decide how a program is built
+typedef struct
+{
+    int opt_level;         // OPT_LEVEL_* (see optimizer/optimizer.h)
+    const char *cache_dir; // Where checked programs are cached (NULL disables the cache)
+} BuildOptions;
+
+// A lexed, parsed, resolved, type-checked and optimized program
+typedef struct
+{
+    ASTNode *ast;          // The first statement
+    size_t slot_count;     // The number of variable slots the resolver assigned
+    Arena *arena;          // Owns the nodes and their strings
+    CachedProgram cached;  // The cache file the program was loaded from, if any
+} Program;
+
+// Everything needed to run one program: the engine's compiled form and its runtime state
+typedef struct
+{
+    const Program *program;
+    ExecutionEngine engine;
+    Chunk *chunk;             // The bytecode, for ENGINE_VM
+    Interpreter *interpreter; // The interpreter, for ENGINE_TREE and ENGINE_JIT
+} Context;
+
+/**
+ * @brief Builds a program from source text.
+ *
+ * Errors are printed, as by the a++c driver. With a cache directory, an
+ * unchanged program is loaded from its cache file instead, and a newly built
+ * one is stored there (unless some statements were rejected).
+ *
+ * @param source The program's source text (need not be NUL-terminated).
+ * @param length The length of the source in bytes.
+ * @param options How to build the program.
+ * @return Program* The program, or NULL if it has errors.
+ */
+Program *build_program(const char *source, size_t length, const BuildOptions *options);
+
+/**
+ * @brief Builds a program from a source file, like build_program().
+ *
+ * @param filename The path to the .a++ file, or "-" for stdin.
+ * @param options How to build the program.
+ * @return Program* The program, or NULL if the file cannot be read or has errors.
+ */
+Program *load_program(const char *filename, const BuildOptions *options);
+
+/**
+ * @brief Frees a program. Free its contexts first.
+ *
+ * @param program A pointer to the Program to be freed.
+ */
+void free_program(Program *program);
+
+/**
+ * @brief Makes a program's nodes read-only.
+ *
+ * Running a program never writes to it; after this, a stray write faults.
+ * The driver freezes a program before forking children that share it
+ * copy-on-write (see --fork-jobs), so no child dirties its pages.
+ *
+ * @param program A pointer to the Program.
+ */
+void freeze_program(Program *program);
+
+/**
+ * @brief Prepares a program to run on an engine.
+ *
+ * This is where the program is compiled to bytecode or native code, so a
+ * context that runs many times compiles only once.
+ *
+ * @param program The program to run; it must outlive the context.
+ * @param engine The engine that runs it.
+ * @return Context* A pointer to the newly created Context, or NULL on error.
+ */
+Context *create_context(const Program *program, ExecutionEngine engine);
+
+/**
+ * @brief Sets a program parameter for the context's following runs.
+ *
+ * A parameter is a variable declared without a value, such as `int n;`,
+ * which otherwise starts out as 0, false or "". The value is read as the
+ * variable's type: a decimal integer, true or false, or any text for a
+ * string. Every declaration of the name without a value is set.
+ *
+ * @param context A pointer to the Context.
+ * @param name The name of the variable.
+ * @param value The value, as text.
+ * @return bool true if it was set; false (with an error reported) if the program has no such parameter or the value does not fit its type.
+ */
+bool set_context_parameter(Context *context, const char *name, const char *value);
+
+/**
+ * @brief Runs the context's program from the start.
+ *
+ * Every run starts with fresh variables. Output and runtime errors are
+ * written to 'out'; it is not flushed, so the caller decides when.
+ *
+ * @param context A pointer to the Context.
+ * @param out The writer that receives the program's output.
+ * @return bool true if the program ran (runtime errors included), false if it could not start.
+ */
+bool run_context(Context *context, Output *out);
+
+/**
+ * @brief Frees a context and its compiled code.
+ *
+ * @param context A pointer to the Context to be freed.
+ */
+void free_context(Context *context);
+
+#endif // CORE_H
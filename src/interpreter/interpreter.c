@@ -1,318 +1,335 @@
 #include "interpreter.h"
 #include "common/types.h"
+#include "common/trace.h"
+#include "common/intmath.h"
+#include "jit/jit.h"
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h> // Add this at the top of the file for the pow() function
 
-// This defines the maximum number of variables our program can handle
-#define MAX_VARIABLES 100
-
-// This structure represents a variable in our program
-typedef struct
+// This structure represents a variable in our program. The type checker has
+// already fixed the type of every slot, so no type tag is stored or checked.
+typedef union
 {
-    char *name;        // The name of the variable
-    VariableType type; // The type of the variable (int or string)
-    union
-    {
-        int int_value; // If it's an int, store the value here
-        char *string_value;
-        bool bool_value;
-    } value;
+    int int_value; // If it's an int, store the value here
+    const char *string_value; // Strings point at literals owned by the AST, so they are never copied
+    bool bool_value;
 } Variable;
 
-// This array stores all the variables in our program
-static Variable variables[MAX_VARIABLES];
-// This keeps track of how many variables we've created
-static int variable_count = 0;
-
-// This function sets the value of a variable
-static void set_variable(const char *name, VariableType type, void *value)
+// The starting value of a declaration without a value
+typedef struct
 {
-    // First, we check if the variable already exists
-    for (int i = 0; i < variable_count; i++)
-    {
-        if (strcmp(variables[i].name, name) == 0)
-        {
-            // If it exists, we update its value
-            variables[i].type = type;
-            if (type == INT_TYPE)
-            {
-                // If it's an int, we store the int value
-                variables[i].value.int_value = *(int *)value;
-            }
-            else if (type == STRING_TYPE)
-            {
-                // If it's a string, we free the old string and store the new one
-                free(variables[i].value.string_value);
-                variables[i].value.string_value = strdup((char *)value);
-            }
-            else if (type == BOOL_TYPE)
-            {
-                variables[i].value.bool_value = *(bool *)value;
-            }
-            return;
-        }
-    }
-
-    // If the variable doesn't exist, we create a new one
-    if (variable_count < MAX_VARIABLES)
-    {
-        // We store the name of the variable
-        variables[variable_count].name = strdup(name);
-        variables[variable_count].type = type;
-        if (type == INT_TYPE)
-        {
-            // If it's an int, we store the int value
-            variables[variable_count].value.int_value = *(int *)value;
-        }
-        else if (type == STRING_TYPE)
-        {
-            // If it's a string, we store a copy of the string
-            variables[variable_count].value.string_value = strdup((char *)value);
-        }
-        variable_count++;
-    }
-    else
-    {
-        // If we've reached the maximum number of variables, we print an error
-        printf("Error: Maximum number of variables reached.\n");
-    }
-}
+    bool set;
+    Variable value;
+    char *string_copy; // Owned copy of a string value
+} Parameter;
 
-static bool strtobool(const char *str)
+// Everything one running program needs. Nothing lives in globals, so several
+// interpreters can run the same or different programs on different threads.
+struct Interpreter
 {
-    return (strcmp(str, "true") == 0 || strcmp(str, "1") == 0);
-}
+    const ASTNode *program; // The first statement; never modified while running
+    Variable *variables;    // Indexed by the slot the resolver assigned
+    size_t variable_count;
+    Parameter *parameters;  // Indexed by slot too; NULL until a parameter is set
+    JitProgram *jit;     // Native code for the integer statements, or NULL
+    Output *output;      // Where print statements and runtime errors go during a run
+};
 
-// This function gets the value of a variable
-static Variable *get_variable(const char *name)
+// This function reports a runtime error in program order with the program's output
+static void runtime_error(Interpreter *interpreter, const char *format, ...)
 {
-    // We loop through all variables
-    for (int i = 0; i < variable_count; i++)
-    {
-        // If we find a variable with the given name, we return it
-        if (strcmp(variables[i].name, name) == 0)
-        {
-            return &variables[i];
-        }
-    }
-    // If we didn't find the variable, we return NULL
-    return NULL;
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    output_string(interpreter->output, message);
+    output_newline(interpreter->output);
 }
 
-// This function evaluates an expression (currently only supports basic operations)
-static int evaluate_expression(ASTNode *node)
+// This function evaluates an integer expression (the type checker has made sure it is one)
+static int evaluate_expression(Interpreter *interpreter, const ASTNode *node)
 {
-    if (node == NULL)
-    {
-        printf("Debug: Null node in evaluate_expression\n");
-        return 0;
-    }
-
-    printf("Debug: Evaluating node type %d\n", node->type);
+    TRACE_DEBUG(TRACE_INTERPRETER, "Evaluating node type %d", node->type);
 
     if (node->type == NODE_INT_LITERAL)
     {
-        printf("Debug: Int literal value: %s\n", node->value);
-        return atoi(node->value);
+        TRACE_DEBUG(TRACE_INTERPRETER, "Int literal value: %d", node->int_value);
+        return node->int_value;
     }
     else if (node->type == NODE_LITERAL)
     {
-        Variable *var = get_variable(node->value);
-        if (var && var->type == INT_TYPE)
-        {
-            printf("Debug: Variable %s value: %d\n", node->value, var->value.int_value);
-            return var->value.int_value;
-        }
-        else
-        {
-            printf("Error: Variable '%s' is not an integer or is undefined.\n", node->value);
-            return 0;
-        }
-    }
-    else if (node->type == NODE_BOOL_LITERAL)
-    {
-        printf("Debug: Bool literal value: %s\n", node->value);
-        return strtobool(node->value);
+        TRACE_DEBUG(TRACE_INTERPRETER, "Variable %s value: %d", node->value, interpreter->variables[node->slot].int_value);
+        return interpreter->variables[node->slot].int_value;
     }
     else if (node->type == NODE_BINARY_OP)
     {
-        int left = evaluate_expression(node->left);
-        int right = evaluate_expression(node->right);
+        int left = evaluate_expression(interpreter, node->left);
+        int right = evaluate_expression(interpreter, node->right);
 
-        printf("Debug: Binary op %s, left: %d, right: %d\n", node->value, left, right);
+        TRACE_DEBUG(TRACE_INTERPRETER, "Binary op %s, left: %d, right: %d", binary_operator_name(node->op), left, right);
 
-        if (strcmp(node->value, "+") == 0)
-            return left + right;
-        if (strcmp(node->value, "-") == 0)
-            return left - right;
-        if (strcmp(node->value, "*") == 0)
-            return left * right;
-        if (strcmp(node->value, "/") == 0)
+        switch (node->op)
         {
+        case BINOP_ADD:
+            return int_add(left, right);
+        case BINOP_SUB:
+            return int_sub(left, right);
+        case BINOP_MUL:
+            return int_mul(left, right);
+        case BINOP_DIV:
             if (right == 0)
             {
-                printf("Error: Division by zero\n");
+                runtime_error(interpreter, "Error: Division by zero");
                 return 0;
             }
-            return left / right;
-        }
-        if (strcmp(node->value, "**") == 0)
-            return (int)pow(left, right);
-        if (strcmp(node->value, "%") == 0)
+            return int_div(left, right);
+        case BINOP_POW:
         {
+            int result;
+            if (!int_pow(left, right, &result))
+            {
+                runtime_error(interpreter, "Error: Integer overflow in '**'");
+                return 0;
+            }
+            return result;
+        }
+        case BINOP_MOD:
             if (right == 0)
             {
-                printf("Error: Modulus by zero\n");
+                runtime_error(interpreter, "Error: Modulus by zero");
                 return 0;
             }
-            return left % right;
+            return int_mod(left, right);
+        default:
+            break;
         }
     }
 
-    printf("Error: Unknown expression type: %d\n", node->type);
+    runtime_error(interpreter, "Error: Unknown expression type: %d", node->type);
     return 0;
 }
 
-static bool evaluate_bool_expression(ASTNode *node)
+// This function evaluates a boolean expression: a literal or a bool variable
+static bool evaluate_bool_expression(Interpreter *interpreter, const ASTNode *node)
+{
+    return node->type == NODE_BOOL_LITERAL ? node->bool_value : interpreter->variables[node->slot].bool_value;
+}
+
+// This function evaluates a string expression: a literal or a string variable
+static const char *evaluate_string_expression(Interpreter *interpreter, const ASTNode *node)
 {
-    if (node->type == NODE_BOOL_LITERAL)
+    return node->type == NODE_STRING_LITERAL ? node->value : interpreter->variables[node->slot].string_value;
+}
+
+// This function creates an interpreter for a program, compiling its integer statements if asked
+Interpreter *create_interpreter(const ASTNode *program, size_t slot_count, bool use_jit)
+{
+    Interpreter *interpreter = (Interpreter *)calloc(1, sizeof(Interpreter));
+    if (!interpreter)
     {
-        return strtobool(node->value);
+        printf("Error: Failed to allocate memory for the interpreter.\n");
+        return NULL;
     }
-    else if (node->type == NODE_LITERAL)
+
+    // Allocate one variable per slot; the resolver has already bound every name
+    interpreter->program = program;
+    interpreter->variable_count = slot_count;
+    interpreter->variables = (Variable *)calloc(slot_count ? slot_count : 1, sizeof(Variable));
+    if (!interpreter->variables)
     {
-        Variable *var = get_variable(node->value);
-        if (var && var->type == BOOL_TYPE)
-        {
-            return var->value.bool_value;
-        }
-        else
-        {
-            printf("Error: Variable '%s' is not a boolean or is undefined.\n", node->value);
-            return false;
-        }
+        printf("Error: Failed to allocate memory for variables.\n");
+        free(interpreter);
+        return NULL;
     }
-    printf("Error: Unknown boolean expression type.\n");
-    return false;
-}
 
-static char *evaluate_string_expression(ASTNode *node)
-{
-    if (node->type == NODE_STRING_LITERAL)
+    // Compile the integer statements up front; the JIT reads and writes the variables array directly
+    if (use_jit)
     {
-        return strdup(node->value);
+        JitSlotLayout layout = {sizeof(Variable), offsetof(Variable, int_value)};
+        interpreter->jit = jit_compile_program(program, &layout);
     }
-    else if (node->type == NODE_LITERAL)
+    return interpreter;
+}
+
+// This function sets the value a declaration without a value starts out with
+void set_interpreter_parameter(Interpreter *interpreter, size_t slot, VariableType type, Value value)
+{
+    if (!interpreter->parameters)
     {
-        Variable *var = get_variable(node->value);
-        if (var && var->type == STRING_TYPE)
+        interpreter->parameters = (Parameter *)calloc(interpreter->variable_count, sizeof(Parameter));
+        if (!interpreter->parameters)
         {
-            return strdup(var->value.string_value);
+            printf("Error: Failed to allocate memory for variables.\n");
+            exit(1);
         }
-        else
+    }
+
+    Parameter *parameter = &interpreter->parameters[slot];
+    free(parameter->string_copy);
+    parameter->string_copy = NULL;
+    parameter->set = true;
+    switch (type)
+    {
+    case INT_TYPE:
+        parameter->value.int_value = value.int_value;
+        break;
+    case BOOL_TYPE:
+        parameter->value.bool_value = value.bool_value;
+        break;
+    case STRING_TYPE:
+        parameter->string_copy = strdup(value.string_value);
+        if (!parameter->string_copy)
         {
-            printf("Error: Variable '%s' is not a string or is undefined.\n", node->value);
-            return strdup("");
+            printf("Error: Failed to allocate memory for variables.\n");
+            exit(1);
         }
+        parameter->value.string_value = parameter->string_copy;
+        break;
+    default:
+        parameter->set = false;
+        break;
     }
-
-    printf("Error: Unknown string expression type.\n");
-    return strdup("");
 }
 
 // This is the main function that interprets our AST
-void interpret(ASTNode *node)
+void run_interpreter(Interpreter *interpreter, Output *out)
 {
+    const ASTNode *node = interpreter->program;
+    JitProgram *jit = interpreter->jit;
+    size_t next_segment = 0;
+    interpreter->output = out;
+
+    // Every run starts from fresh variables, so earlier runs leave nothing behind
+    memset(interpreter->variables, 0, (interpreter->variable_count ? interpreter->variable_count : 1) * sizeof(Variable));
+
     // We loop through each node in our AST
     while (node != NULL)
     {
-        printf("Debug: Interpreting node type %d\n", node->type);
+        // Statements that were compiled run natively, as one call per run of statements
+        if (jit && next_segment < jit->segment_count && jit->segments[next_segment].first == node)
+        {
+            const JitSegment *segment = &jit->segments[next_segment++];
+            jit_run_segment(segment, interpreter->variables, out);
+            node = segment->next;
+            continue;
+        }
+
+        TRACE_DEBUG(TRACE_INTERPRETER, "Interpreting node type %d", node->type);
 
         switch (node->type)
         {
         case NODE_VAR_DECLARATION:
         {
-            printf("Debug: Variable declaration %s\n", node->var_name);
-            if (strcmp(node->var_type, "int") == 0)
+            // Variables without an initializer start out as 0, false or ""
+            TRACE_DEBUG(TRACE_INTERPRETER, "Variable declaration %s", node->var_name);
+            Variable *var = &interpreter->variables[node->slot];
+            if (!node->left && interpreter->parameters && interpreter->parameters[node->slot].set)
             {
-                int value = node->left ? evaluate_expression(node->left) : 0;
-                printf("Debug: Setting variable %s to %d\n", node->var_name, value);
-                set_variable(node->var_name, INT_TYPE, &value);
-            }
-            else if (strcmp(node->var_type, "string") == 0)
-            {
-                char *value = node->left ? evaluate_string_expression(node->left) : strdup("");
-                printf("Debug: Setting variable %s to %s\n", node->var_name, value);
-                set_variable(node->var_name, STRING_TYPE, value);
-                free(value);
+                *var = interpreter->parameters[node->slot].value;
+                break;
             }
-            else if (strcmp(node->var_type, "bool") == 0)
+            switch (node->value_type)
             {
-                bool value = node->left ? evaluate_bool_expression(node->left) : false;
-                printf("Debug: Setting variable %s to %s\n", node->var_name, value ? "true" : "false");
-                set_variable(node->var_name, BOOL_TYPE, &value);
+            case INT_TYPE:
+                var->int_value = node->left ? evaluate_expression(interpreter, node->left) : 0;
+                break;
+            case STRING_TYPE:
+                var->string_value = node->left ? evaluate_string_expression(interpreter, node->left) : "";
+                break;
+            case BOOL_TYPE:
+                var->bool_value = node->left ? evaluate_bool_expression(interpreter, node->left) : false;
+                break;
+            default:
+                break;
             }
             break;
         }
         case NODE_PRINT:
         {
-            printf("Debug: Print statement\n");
-            if (node->left->type == NODE_INT_LITERAL ||
-                (node->left->type == NODE_LITERAL && get_variable(node->left->value)->type == INT_TYPE) ||
-                node->left->type == NODE_BINARY_OP)
+            TRACE_DEBUG(TRACE_INTERPRETER, "Print statement");
+            const ASTNode *value = node->left;
+            switch (value->value_type)
             {
-                int result = evaluate_expression(node->left);
-                printf("%d\n", result);
-            }
-            else if (node->left->type == NODE_BOOL_LITERAL ||
-                     (node->left->type == NODE_LITERAL && get_variable(node->left->value)->type == BOOL_TYPE))
-            {
-                bool result = evaluate_bool_expression(node->left);
-                printf("%s\n", result ? "true" : "false");
-            }
-            else
-            {
-                char *result = evaluate_string_expression(node->left);
-                printf("%s\n", result);
-                free(result);
+            case INT_TYPE:
+                output_int(interpreter->output, evaluate_expression(interpreter, value));
+                break;
+            case BOOL_TYPE:
+                output_bool(interpreter->output, evaluate_bool_expression(interpreter, value));
+                break;
+            case STRING_TYPE:
+                // String literals know their length, so they are written without a strlen;
+                // variables are written straight from where they live, without a copy
+                if (value->type == NODE_STRING_LITERAL)
+                    output_write(interpreter->output, value->value, value->value_length);
+                else
+                    output_string(interpreter->output, interpreter->variables[value->slot].string_value);
+                break;
+            default:
+                break;
             }
+            output_newline(interpreter->output);
             break;
         }
         case NODE_ASSIGNMENT:
         {
-             printf("Debug: Assignment to %s\n", node->var_name);
-            Variable *var = get_variable(node->var_name);
-            if (var == NULL)
+            TRACE_DEBUG(TRACE_INTERPRETER, "Assignment to %s", node->var_name);
+            Variable *var = &interpreter->variables[node->slot];
+            switch (node->value_type)
             {
-                printf("Error: Undefined variable %s\n", node->var_name);
+            case INT_TYPE:
+                var->int_value = evaluate_expression(interpreter, node->left);
+                break;
+            case STRING_TYPE:
+                var->string_value = evaluate_string_expression(interpreter, node->left);
+                break;
+            case BOOL_TYPE:
+                var->bool_value = evaluate_bool_expression(interpreter, node->left);
+                break;
+            default:
                 break;
-            }
-            if (var->type == BOOL_TYPE)
-            {
-                bool value = evaluate_bool_expression(node->left);
-                set_variable(node->var_name, BOOL_TYPE, &value);
-            }
-            else if (var->type == INT_TYPE)
-            {
-                int value = evaluate_expression(node->left);
-                set_variable(node->var_name, INT_TYPE, &value);
-            }
-            else if (var->type == STRING_TYPE)
-            {
-                char *value = evaluate_string_expression(node->left);
-                set_variable(node->var_name, STRING_TYPE, value);
-                free(value);
             }
             break;
         }
         default:
-            printf("Error: Unknown node type in interpreter: %d\n", node->type);
+            runtime_error(interpreter, "Error: Unknown node type in interpreter: %d", node->type);
             break;
         }
         // Move to the next node
         node = node->next;
     }
+
+    interpreter->output = NULL;
+}
+
+// This function frees an interpreter, its variables and its native code
+void free_interpreter(Interpreter *interpreter)
+{
+    if (interpreter)
+    {
+        // The variables' strings belong to the AST, so only the array itself is freed
+        free_jit_program(interpreter->jit);
+        for (size_t i = 0; interpreter->parameters && i < interpreter->variable_count; i++)
+        {
+            free(interpreter->parameters[i].string_copy);
+        }
+        free(interpreter->parameters);
+        free(interpreter->variables);
+        free(interpreter);
+    }
+}
+
+// This function runs a program once with a temporary interpreter
+void interpret(const ASTNode *node, size_t slot_count, Output *out, bool use_jit)
+{
+    Interpreter *interpreter = create_interpreter(node, slot_count, use_jit);
+    if (interpreter)
+    {
+        run_interpreter(interpreter, out);
+        free_interpreter(interpreter);
+    }
 }
@@ -2,15 +2,79 @@
 #define INTERPRETER_H
 
 #include "ast/ast.h"
+#include "runtime/output.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// The runtime state of one program: its variables and its native code.
+// Create one per thread to run programs concurrently.
+typedef struct Interpreter Interpreter;
+
+/**
+ * @brief Creates an interpreter that can run a program any number of times.
+ *
+ * The program must have passed typecheck_program() (see semantic/typecheck.h)
+ * and must outlive the interpreter; it is only read, so several interpreters
+ * may share one program. If 'use_jit' is set, runs of integer declarations
+ * and assignments are compiled to native code once, here.
+ *
+ * @param program The root node of the AST (the first statement in the list).
+ * @param slot_count The number of variable slots assigned by the resolver.
+ * @param use_jit Whether to compile integer statements to native code.
+ * @return Interpreter* A pointer to the newly created Interpreter, or NULL if memory ran out.
+ */
+Interpreter *create_interpreter(const ASTNode *program, size_t slot_count, bool use_jit);
+
+/**
+ * @brief Sets the starting value of a declaration without a value, for the following runs.
+ *
+ * Such a declaration is a program parameter: without a value set here, its
+ * variable starts out as 0, false or "".
+ *
+ * @param interpreter A pointer to the Interpreter.
+ * @param slot The variable slot of the declaration.
+ * @param type The declared type of the variable.
+ * @param value The value; strings are copied.
+ */
+void set_interpreter_parameter(Interpreter *interpreter, size_t slot, VariableType type, Value value);
+
+/**
+ * @brief Runs the interpreter's program from the start.
+ *
+ * Every run starts with fresh variables, so runs are independent of each other.
+ *
+ * @param interpreter A pointer to the Interpreter.
+ * @param out The writer that receives print output and runtime errors.
+ */
+void run_interpreter(Interpreter *interpreter, Output *out);
+
+/**
+ * @brief Frees an interpreter and its native code.
+ *
+ * @param interpreter A pointer to the Interpreter to be freed.
+ */
+void free_interpreter(Interpreter *interpreter);
 
 /**
  * @brief Interprets and executes the given Abstract Syntax Tree.
  * 
  * This function walks through the AST, executing each node according to its type.
  * It handles variable declarations, assignments, and print statements.
+ * The AST must have passed typecheck_program() (see semantic/typecheck.h):
+ * each statement runs the code for its annotated type, with no type checks.
+ * If 'use_jit' is set, runs of integer declarations and assignments are
+ * first compiled to native code (see src/jit/jit.h) and executed directly;
+ * every other statement is still interpreted. Without JIT support on this
+ * platform the whole program is interpreted.
+ *
+ * This is a shortcut for create_interpreter(), run_interpreter() and
+ * free_interpreter().
  * 
  * @param node The root node of the AST to be interpreted.
+ * @param slot_count The number of variable slots assigned by the resolver.
+ * @param out The writer that receives print output and runtime errors.
+ * @param use_jit Whether to compile integer statements to native code.
  */
-void interpret(ASTNode *node);
+void interpret(const ASTNode *node, size_t slot_count, Output *out, bool use_jit);
 
 #endif // INTERPRETER_H
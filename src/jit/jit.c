@@ -0,0 +1,485 @@
+#include "jit.h"
+#include "common/intmath.h"
+#include "common/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Native code is only generated for x86-64; elsewhere every statement is interpreted
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JIT_X86_64 1
+#else
+#define JIT_X86_64 0
+#endif
+
+// Passed to the native code in a register, and on to the helpers it calls
+typedef struct
+{
+    Output *out;
+} JitContext;
+
+bool jit_available(void)
+{
+    return JIT_X86_64;
+}
+
+// This function runs a segment, giving its helpers access to the program's output
+void jit_run_segment(const JitSegment *segment, void *slots, Output *out)
+{
+    JitContext context = {out};
+    segment->function(slots, &context);
+}
+
+#if JIT_X86_64
+
+// This function performs '/' for native code, reporting division by zero like the interpreter
+static int jit_divide(JitContext *context, int left, int right)
+{
+    if (right == 0)
+    {
+        output_string(context->out, "Error: Division by zero");
+        output_newline(context->out);
+        return 0;
+    }
+    return int_div(left, right); // INT_MIN / -1 would trap in idiv
+}
+
+// This function performs '%' for native code
+static int jit_modulus(JitContext *context, int left, int right)
+{
+    if (right == 0)
+    {
+        output_string(context->out, "Error: Modulus by zero");
+        output_newline(context->out);
+        return 0;
+    }
+    return int_mod(left, right);
+}
+
+// This function performs '**' for native code
+static int jit_power(JitContext *context, int left, int right)
+{
+    int result;
+    if (!int_pow(left, right, &result))
+    {
+        output_string(context->out, "Error: Integer overflow in '**'");
+        output_newline(context->out);
+        return 0;
+    }
+    return result;
+}
+
+// Machine code is assembled here before being copied into executable memory
+typedef struct
+{
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} CodeBuffer;
+
+// State carried through one compilation
+typedef struct
+{
+    CodeBuffer code;
+    const JitSlotLayout *layout;
+    int depth; // Values pushed on the machine stack, to keep calls 16-byte aligned
+} JitCompiler;
+
+// This function grows the code buffer so that 'length' more bytes fit
+static void reserve_code(CodeBuffer *code, size_t length)
+{
+    size_t capacity = code->capacity ? code->capacity * 2 : 4096;
+    while (code->length + length > capacity)
+    {
+        capacity *= 2;
+    }
+    code->data = realloc(code->data, capacity);
+    if (!code->data)
+    {
+        printf("Error: Failed to allocate memory for native code.\n");
+        exit(1);
+    }
+    code->capacity = capacity;
+}
+
+// This function appends raw bytes to the code buffer. It is inlined into every
+// EMIT, so the copy has a constant size and compiles to a few stores.
+static inline void emit_bytes(CodeBuffer *code, const void *bytes, size_t length)
+{
+    if (code->length + length > code->capacity)
+    {
+        reserve_code(code, length);
+    }
+    memcpy(code->data + code->length, bytes, length);
+    code->length += length;
+}
+
+// Emits an instruction given as a list of byte values
+#define EMIT(jit, ...)                                       \
+    do                                                       \
+    {                                                        \
+        const uint8_t bytes_[] = {__VA_ARGS__};              \
+        emit_bytes(&(jit)->code, bytes_, sizeof(bytes_));    \
+    } while (0)
+
+static void emit_u32(JitCompiler *jit, uint32_t value)
+{
+    emit_bytes(&jit->code, &value, sizeof(value)); // x86-64 is little-endian, like the encoding
+}
+
+static void emit_u64(JitCompiler *jit, uint64_t value)
+{
+    emit_bytes(&jit->code, &value, sizeof(value));
+}
+
+// This function computes the [rbx + disp32] displacement of a field of 'slot'
+static bool slot_displacement(const JitCompiler *jit, int slot, size_t offset, uint32_t *displacement)
+{
+    size_t value = (size_t)slot * jit->layout->stride + offset;
+    if (slot < 0 || value > INT32_MAX)
+    {
+        return false;
+    }
+    *displacement = (uint32_t)value;
+    return true;
+}
+
+// This function finds where an integer variable is stored; it fails for any other variable.
+// 'node' is an identifier, declaration or assignment annotated by the type checker.
+static bool int_variable(const JitCompiler *jit, const ASTNode *node, uint32_t *displacement)
+{
+    return node->value_type == INT_TYPE &&
+           slot_displacement(jit, node->slot, jit->layout->int_offset, displacement);
+}
+
+// This function reports whether an operand can be used directly, without evaluating it into a register
+static bool is_leaf(const JitCompiler *jit, const ASTNode *node)
+{
+    uint32_t displacement;
+    return node->type == NODE_INT_LITERAL || (node->type == NODE_LITERAL && int_variable(jit, node, &displacement));
+}
+
+// This function loads a leaf operand into ecx
+static void emit_load_ecx(JitCompiler *jit, const ASTNode *leaf)
+{
+    if (leaf->type == NODE_INT_LITERAL)
+    {
+        EMIT(jit, 0xB9); // mov ecx, imm32
+        emit_u32(jit, (uint32_t)leaf->int_value);
+    }
+    else
+    {
+        uint32_t displacement = 0;
+        int_variable(jit, leaf, &displacement);
+        EMIT(jit, 0x8B, 0x8B); // mov ecx, [rbx + disp32]
+        emit_u32(jit, displacement);
+    }
+}
+
+// This function calls helper(context, eax, ecx), leaving the result in eax
+static void emit_helper_call(JitCompiler *jit, int (*helper)(JitContext *, int, int))
+{
+    bool misaligned = (jit->depth & 1) != 0;
+    EMIT(jit, 0x4C, 0x89, 0xE7); // mov rdi, r12
+    EMIT(jit, 0x89, 0xC6);       // mov esi, eax
+    EMIT(jit, 0x89, 0xCA);       // mov edx, ecx
+    if (misaligned)
+    {
+        EMIT(jit, 0x48, 0x83, 0xEC, 0x08); // sub rsp, 8
+    }
+    EMIT(jit, 0x48, 0xB8); // mov rax, imm64
+    emit_u64(jit, (uint64_t)(uintptr_t)helper);
+    EMIT(jit, 0xFF, 0xD0); // call rax
+    if (misaligned)
+    {
+        EMIT(jit, 0x48, 0x83, 0xC4, 0x08); // add rsp, 8
+    }
+}
+
+// This function applies a binary operator to eax and ecx, leaving the result in eax
+static bool emit_operator_ecx(JitCompiler *jit, BinaryOperator op)
+{
+    switch (op)
+    {
+    case BINOP_ADD:
+        EMIT(jit, 0x01, 0xC8); // add eax, ecx
+        return true;
+    case BINOP_SUB:
+        EMIT(jit, 0x29, 0xC8); // sub eax, ecx
+        return true;
+    case BINOP_MUL:
+        EMIT(jit, 0x0F, 0xAF, 0xC1); // imul eax, ecx
+        return true;
+    case BINOP_DIV:
+        emit_helper_call(jit, jit_divide);
+        return true;
+    case BINOP_MOD:
+        emit_helper_call(jit, jit_modulus);
+        return true;
+    case BINOP_POW:
+        emit_helper_call(jit, jit_power);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// This function evaluates an expression into eax, or returns false if it is not integer
+// arithmetic the JIT supports. Operands are evaluated left to right, like the interpreter,
+// so runtime errors are reported in the same order. Support is checked while emitting, so
+// the AST is walked once; the caller throws away the code of a rejected statement.
+static bool emit_expression(JitCompiler *jit, const ASTNode *node)
+{
+    uint32_t displacement = 0;
+
+    switch (node->type)
+    {
+    case NODE_INT_LITERAL:
+        EMIT(jit, 0xB8); // mov eax, imm32
+        emit_u32(jit, (uint32_t)node->int_value);
+        return true;
+
+    case NODE_LITERAL:
+        if (!int_variable(jit, node, &displacement))
+            return false;
+        EMIT(jit, 0x8B, 0x83); // mov eax, [rbx + disp32]
+        emit_u32(jit, displacement);
+        return true;
+
+    case NODE_BINARY_OP:
+        break;
+
+    default:
+        return false;
+    }
+
+    const ASTNode *right = node->right;
+    if (!emit_expression(jit, node->left))
+    {
+        return false;
+    }
+
+    if (is_leaf(jit, right) && (node->op == BINOP_ADD || node->op == BINOP_SUB || node->op == BINOP_MUL))
+    {
+        // Simple operands are folded into the instruction itself
+        if (right->type == NODE_INT_LITERAL)
+        {
+            if (node->op == BINOP_ADD)
+                EMIT(jit, 0x05); // add eax, imm32
+            else if (node->op == BINOP_SUB)
+                EMIT(jit, 0x2D); // sub eax, imm32
+            else
+                EMIT(jit, 0x69, 0xC0); // imul eax, eax, imm32
+            emit_u32(jit, (uint32_t)right->int_value);
+        }
+        else
+        {
+            int_variable(jit, right, &displacement);
+            if (node->op == BINOP_ADD)
+                EMIT(jit, 0x03, 0x83); // add eax, [rbx + disp32]
+            else if (node->op == BINOP_SUB)
+                EMIT(jit, 0x2B, 0x83); // sub eax, [rbx + disp32]
+            else
+                EMIT(jit, 0x0F, 0xAF, 0x83); // imul eax, [rbx + disp32]
+            emit_u32(jit, displacement);
+        }
+        return true;
+    }
+
+    if (is_leaf(jit, right))
+    {
+        emit_load_ecx(jit, right);
+    }
+    else
+    {
+        // Keep the left value on the stack while the right operand is computed
+        EMIT(jit, 0x50); // push rax
+        jit->depth++;
+        if (!emit_expression(jit, right))
+        {
+            return false;
+        }
+        EMIT(jit, 0x89, 0xC1); // mov ecx, eax
+        EMIT(jit, 0x58);       // pop rax
+        jit->depth--;
+    }
+    return emit_operator_ecx(jit, node->op);
+}
+
+// This function compiles an integer declaration or assignment into the current segment.
+// It returns false if the statement has to be interpreted instead.
+static bool emit_statement(JitCompiler *jit, const ASTNode *node)
+{
+    // Declarations and assignments carry their variable's type, like identifiers
+    uint32_t value_displacement;
+    if ((node->type != NODE_VAR_DECLARATION && node->type != NODE_ASSIGNMENT) ||
+        !int_variable(jit, node, &value_displacement))
+    {
+        return false;
+    }
+
+    // A declaration without a value is a parameter, whose starting value is
+    // set per run (see set_interpreter_parameter()), so it is interpreted
+    if (!node->left || !emit_expression(jit, node->left))
+    {
+        return false;
+    }
+
+    EMIT(jit, 0x89, 0x83); // mov [rbx + disp32], eax
+    emit_u32(jit, value_displacement);
+    return true;
+}
+
+static void emit_prologue(JitCompiler *jit)
+{
+    // rbx holds the slots and r12 the context for the whole segment; the third push
+    // leaves the stack 16-byte aligned for helper calls
+    EMIT(jit, 0x53);             // push rbx
+    EMIT(jit, 0x41, 0x54);       // push r12
+    EMIT(jit, 0x55);             // push rbp
+    EMIT(jit, 0x48, 0x89, 0xFB); // mov rbx, rdi
+    EMIT(jit, 0x49, 0x89, 0xF4); // mov r12, rsi
+}
+
+static void emit_epilogue(JitCompiler *jit)
+{
+    EMIT(jit, 0x5D);       // pop rbp
+    EMIT(jit, 0x41, 0x5C); // pop r12
+    EMIT(jit, 0x5B);       // pop rbx
+    EMIT(jit, 0xC3);       // ret
+}
+
+// This function records a finished segment; its code offset is turned into a pointer later
+static void add_segment(JitProgram *program, size_t *capacity, const ASTNode *first, const ASTNode *next, size_t offset)
+{
+    if (program->segment_count == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        program->segments = realloc(program->segments, *capacity * sizeof(JitSegment));
+        if (!program->segments)
+        {
+            printf("Error: Failed to allocate memory for native code.\n");
+            exit(1);
+        }
+    }
+    JitSegment *segment = &program->segments[program->segment_count++];
+    segment->first = first;
+    segment->next = next;
+    segment->function = (JitFunction)(uintptr_t)offset;
+}
+
+// This function compiles every run of supported statements into one executable mapping
+JitProgram *jit_compile_program(const ASTNode *node, const JitSlotLayout *layout)
+{
+    JitProgram *program = (JitProgram *)calloc(1, sizeof(JitProgram));
+    JitCompiler jit;
+    memset(&jit, 0, sizeof(jit));
+    jit.layout = layout;
+    if (!program)
+    {
+        printf("Error: Failed to allocate memory for native code.\n");
+        exit(1);
+    }
+
+    size_t capacity = 0;
+    const ASTNode *run_start = NULL;
+    size_t run_offset = 0;
+    for (; node != NULL; node = node->next)
+    {
+        // An open run is extended in place; a rejected statement's partial code is dropped
+        size_t mark = jit.code.length;
+        bool opening = run_start == NULL;
+        if (opening)
+        {
+            emit_prologue(&jit);
+        }
+
+        if (emit_statement(&jit, node))
+        {
+            if (opening)
+            {
+                run_start = node;
+                run_offset = mark;
+            }
+        }
+        else
+        {
+            jit.code.length = mark;
+            jit.depth = 0;
+            if (run_start != NULL)
+            {
+                emit_epilogue(&jit);
+                add_segment(program, &capacity, run_start, node, run_offset);
+                run_start = NULL;
+            }
+        }
+    }
+    if (run_start != NULL)
+    {
+        emit_epilogue(&jit);
+        add_segment(program, &capacity, run_start, NULL, run_offset);
+    }
+
+    if (program->segment_count > 0)
+    {
+        // Write the code while the mapping is writable, then make it executable but read-only
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        program->code_size = (jit.code.length + page - 1) / page * page;
+        program->code = mmap(NULL, program->code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (program->code != MAP_FAILED)
+        {
+            memcpy(program->code, jit.code.data, jit.code.length);
+            if (mprotect(program->code, program->code_size, PROT_READ | PROT_EXEC) != 0)
+            {
+                munmap(program->code, program->code_size);
+                program->code = MAP_FAILED;
+            }
+        }
+        if (program->code == MAP_FAILED)
+        {
+            // Without executable memory every statement is simply interpreted
+            TRACE(TRACE_JIT, TRACE_LEVEL_WARN, "Could not map executable memory; falling back to the interpreter");
+            program->code = NULL;
+            program->code_size = 0;
+            program->segment_count = 0;
+        }
+
+        for (size_t i = 0; i < program->segment_count; i++)
+        {
+            size_t offset = (size_t)(uintptr_t)program->segments[i].function;
+            program->segments[i].function = (JitFunction)(uintptr_t)((uint8_t *)program->code + offset);
+        }
+    }
+
+    TRACE_INFO(TRACE_JIT, "Compiled %zu segments, %zu bytes of machine code", program->segment_count, jit.code.length);
+    free(jit.code.data);
+    return program;
+}
+
+#else // !JIT_X86_64
+
+JitProgram *jit_compile_program(const ASTNode *node, const JitSlotLayout *layout)
+{
+    (void)node;
+    (void)layout;
+    return NULL;
+}
+
+#endif // JIT_X86_64
+
+// This function frees the segments and unmaps their code
+void free_jit_program(JitProgram *program)
+{
+    if (!program)
+    {
+        return;
+    }
+    if (program->code)
+    {
+        munmap(program->code, program->code_size);
+    }
+    free(program->segments);
+    free(program);
+}
@@ -0,0 +1,76 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "ast/ast.h"
+#include "runtime/output.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Describes how the caller stores its variables, so native code can read and write them directly
+typedef struct
+{
+    size_t stride;     // Bytes between consecutive slots
+    size_t int_offset; // Offset of the int value inside a slot
+} JitSlotLayout;
+
+// A native function executing a run of consecutive statements
+typedef void (*JitFunction)(void *slots, void *context);
+
+// One run of statements that was compiled to machine code
+typedef struct
+{
+    const ASTNode *first; // First statement of the run
+    const ASTNode *next;  // First statement after the run (NULL at the end of the program)
+    JitFunction function; // Executes the whole run
+} JitSegment;
+
+// The native code for a program, in program order
+typedef struct
+{
+    JitSegment *segments;
+    size_t segment_count;
+    void *code; // One executable mapping holding every segment
+    size_t code_size;
+} JitProgram;
+
+/**
+ * @brief Reports whether this build can generate native code (x86-64 only).
+ *
+ * @return bool true if jit_compile_program() can produce segments.
+ */
+bool jit_available(void);
+
+/**
+ * @brief Compiles every run of integer declarations and assignments in a type-checked program.
+ *
+ * Statements the JIT does not support (prints, and anything involving
+ * strings or booleans) are left out of the segments. The caller interprets
+ * them and runs a segment whenever it reaches the segment's first statement.
+ * Division, modulus and '**' call back into C, so runtime errors match the
+ * interpreter. Which statements are integer ones is read from the type
+ * checker's annotations (see semantic/typecheck.h).
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param layout How the caller stores its variables.
+ * @return JitProgram* The compiled segments (possibly none), or NULL if native code is not available.
+ */
+JitProgram *jit_compile_program(const ASTNode *node, const JitSlotLayout *layout);
+
+/**
+ * @brief Executes one compiled segment.
+ *
+ * @param segment The segment to run.
+ * @param slots The caller's variable storage, laid out as described at compile time.
+ * @param out The writer that receives runtime errors.
+ */
+void jit_run_segment(const JitSegment *segment, void *slots, Output *out);
+
+/**
+ * @brief Frees a compiled program and unmaps its code.
+ *
+ * @param program A pointer to the JitProgram to be freed.
+ */
+void free_jit_program(JitProgram *program);
+
+#endif // JIT_H
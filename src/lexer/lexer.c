@@ -1,26 +1,38 @@
 #include "lexer.h"
+#include "scan.h"
+#include "common/report.h"
+#include "common/trace.h"
 // #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <limits.h>
 
-// Initialize the lexer
+// Initialize the lexer over a NUL-terminated string
 Lexer *init_lexer(const char *input)
 {
-    Lexer *lexer = (Lexer *)malloc(sizeof(Lexer)); // Allocate memory for a new Lexer structure
-    lexer->input = input;                          // Set the input string for the lexer
-    lexer->position = 0;                           // Initialize the current position to the start of the input
-    lexer->read_position = 1;                      // Set the read position to the next character
-    lexer->current_char = input[0];                // Set the current character to the first character of the input
-    return lexer;                                  // Return the newly created lexer
+    return init_lexer_n(input, strlen(input)); // Measure the input once, up front
+}
+
+// Initialize the lexer over a buffer of known length (no NUL terminator needed)
+Lexer *init_lexer_n(const char *input, size_t length)
+{
+    Lexer *lexer = (Lexer *)malloc(sizeof(Lexer));          // Allocate memory for a new Lexer structure
+    lexer->input = input;                                   // Set the input buffer for the lexer
+    lexer->length = length;                                 // Remember how many bytes the input holds
+    lexer->position = 0;                                    // Initialize the current position to the start of the input
+    lexer->read_position = 1;                               // Set the read position to the next character
+    lexer->current_char = length > 0 ? input[0] : '\0';     // Set the current character to the first character of the input
+    lexer->had_error = false;                               // Nothing has been reported yet
+    return lexer;                                           // Return the newly created lexer
 }
 
 // This function moves the lexer to the next character
 void advance(Lexer *lexer)
 {
     // If we haven't reached the end of the input
-    if (lexer->read_position < strlen(lexer->input))
+    if (lexer->read_position < lexer->length)
     {
         lexer->position = lexer->read_position;              // Move the current position forward
         lexer->current_char = lexer->input[lexer->position]; // Set the current character to the next character
@@ -28,96 +40,209 @@ void advance(Lexer *lexer)
     }
     else
     {
-        // If we've reached the end, set the current character to null
+        // If we've reached the end, point just past the input and set the current character to null
+        lexer->position = lexer->length;
         lexer->current_char = '\0';
     }
 }
 
-// This function identifies keywords or identifiers
-static Token *identifier_or_keyword(Lexer *lexer)
+// This function moves the lexer to 'position', which the scanning routines returned
+static void seek(Lexer *lexer, size_t position)
 {
-    char buffer[256] = {0};                                            // Initialize a buffer to store the identifier
-    int i = 0;                                                         // Initialize an index for the buffer
-    while (isalnum(lexer->current_char) || lexer->current_char == '_') // While the current character is alphanumeric or an underscore
+    lexer->position = position;
+    lexer->read_position = position + 1;
+    lexer->current_char = position < lexer->length ? lexer->input[position] : '\0';
+}
+
+// This function reports a scanning error at the line and column of input[position]
+static void report_at(Lexer *lexer, size_t position, const char *message)
+{
+    size_t line = 1;
+    size_t line_start = 0;
+    for (size_t i = 0; i < position; i++)
     {
-        buffer[i++] = lexer->current_char; // Add the current character to the buffer
-        advance(lexer);                    // Move to the next character
+        if (lexer->input[i] == '\n')
+        {
+            line++;
+            line_start = i + 1;
+        }
     }
-    buffer[i] = '\0'; // Null-terminate the buffer
-
-    Token *token = malloc(sizeof(Token)); // Allocate memory for a new token
-    token->value = strdup(buffer);        // Duplicate the buffer to store the identifier
-
-    // Check if the buffer matches any keywords
-    if (strcmp(buffer, "int") == 0)
-        token->type = TOKEN_INT_TYPE;
-    else if (strcmp(buffer, "string") == 0)
-        token->type = TOKEN_STRING_TYPE;
-    else if (strcmp(buffer, "print") == 0 || strcmp(buffer, "echo") == 0)
-        token->type = TOKEN_PRINT;
-    else if (strcmp(buffer, "bool") == 0)
-        token->type = TOKEN_BOOL_TYPE;
-    else
-        token->type = TOKEN_IDENTIFIER; // If it's not a keyword, it's an identifier
+    report("Error: %s at line %zu, column %zu\n", message, line, position - line_start + 1);
+    lexer->had_error = true;
+}
 
-    return token; // Return the token
+// This function creates a token covering input[start, start + length)
+static Token make_token(TokenType type, size_t start, size_t length)
+{
+    Token token;
+    token.type = type;
+    token.start = start;
+    token.length = length;
+    token.int_value = 0;
+    return token;
 }
 
-static Token *boolean(Lexer *lexer)
+// Every reserved word, indexed by KeywordType
+static const KeywordInfo keywords[KEYWORD_COUNT] = {
+    [KEYWORD_PRINT] = {"print", TOKEN_PRINT, KEYWORD_PRINT},
+    [KEYWORD_ECHO] = {"echo", TOKEN_PRINT, KEYWORD_ECHO},
+    [KEYWORD_IF] = {"if", TOKEN_KEYWORD, KEYWORD_IF},
+    [KEYWORD_ELSE] = {"else", TOKEN_KEYWORD, KEYWORD_ELSE},
+    [KEYWORD_ELSEIF] = {"elseif", TOKEN_KEYWORD, KEYWORD_ELSEIF},
+    [KEYWORD_BREAK] = {"break", TOKEN_KEYWORD, KEYWORD_BREAK},
+    [KEYWORD_CONTINUE] = {"continue", TOKEN_KEYWORD, KEYWORD_CONTINUE},
+    [KEYWORD_VOID] = {"void", TOKEN_KEYWORD, KEYWORD_VOID},
+    [KEYWORD_RETURN] = {"return", TOKEN_KEYWORD, KEYWORD_RETURN},
+    [KEYWORD_CONST] = {"const", TOKEN_KEYWORD, KEYWORD_CONST},
+    [KEYWORD_INT] = {"int", TOKEN_INT_TYPE, KEYWORD_INT},
+    [KEYWORD_FLOAT] = {"float", TOKEN_FLOAT_TYPE, KEYWORD_FLOAT},
+    [KEYWORD_BOOL] = {"bool", TOKEN_BOOL_TYPE, KEYWORD_BOOL},
+    [KEYWORD_CHAR] = {"char", TOKEN_CHAR_TYPE, KEYWORD_CHAR},
+    [KEYWORD_SHORT] = {"short", TOKEN_SHORT_TYPE, KEYWORD_SHORT},
+    [KEYWORD_LONG] = {"long", TOKEN_LONG_TYPE, KEYWORD_LONG},
+    [KEYWORD_UNSIGNED] = {"unsigned", TOKEN_UNSIGNED_TYPE, KEYWORD_UNSIGNED},
+    [KEYWORD_SIGNED] = {"signed", TOKEN_SIGNED_TYPE, KEYWORD_SIGNED},
+    [KEYWORD_DOUBLE] = {"double", TOKEN_DOUBLE_TYPE, KEYWORD_DOUBLE},
+    [KEYWORD_STRING] = {"string", TOKEN_STRING_TYPE, KEYWORD_STRING},
+    [KEYWORD_TRUE] = {"true", TOKEN_BOOL, KEYWORD_TRUE},
+    [KEYWORD_FALSE] = {"false", TOKEN_BOOL, KEYWORD_FALSE},
+};
+
+// Packs a word's length with its first and last characters. No two keywords share
+// all three, so this key is a perfect hash of the keyword set.
+#define KEYWORD_KEY(length, first, last) \
+    (((unsigned)(length) << 16) | ((unsigned)(unsigned char)(first) << 8) | (unsigned)(unsigned char)(last))
+
+// This function finds the only keyword a word could be, then checks it with a single compare
+const KeywordInfo *lookup_keyword(const char *text, size_t length)
 {
-    char buffer[6] = {0}; // "true" and "false" are at most 5 characters long
-    int i = 0;
-    while (isalpha(lexer->current_char))
+    if (length < 2 || length > 8)
     {
-        buffer[i++] = lexer->current_char;
-        advance(lexer);
+        return NULL;
     }
-    buffer[i] = '\0';
-    Token *token = malloc(sizeof(Token));
-
-    if (strcmp(buffer, "true") == 0 || strcmp(buffer, "false") == 0) {
-        token->type = TOKEN_BOOL;
-        token->value = strdup(buffer);
-    } else {
-          // If it's not "true" or "false", treat it as an identifier
-        token->type = TOKEN_IDENTIFIER;
-        token->value = strdup(buffer);
+
+    KeywordType keyword;
+    switch (KEYWORD_KEY(length, text[0], text[length - 1]))
+    {
+    case KEYWORD_KEY(2, 'i', 'f'): keyword = KEYWORD_IF; break;
+    case KEYWORD_KEY(3, 'i', 't'): keyword = KEYWORD_INT; break;
+    case KEYWORD_KEY(4, 'b', 'l'): keyword = KEYWORD_BOOL; break;
+    case KEYWORD_KEY(4, 'c', 'r'): keyword = KEYWORD_CHAR; break;
+    case KEYWORD_KEY(4, 'e', 'o'): keyword = KEYWORD_ECHO; break;
+    case KEYWORD_KEY(4, 'e', 'e'): keyword = KEYWORD_ELSE; break;
+    case KEYWORD_KEY(4, 'l', 'g'): keyword = KEYWORD_LONG; break;
+    case KEYWORD_KEY(4, 't', 'e'): keyword = KEYWORD_TRUE; break;
+    case KEYWORD_KEY(4, 'v', 'd'): keyword = KEYWORD_VOID; break;
+    case KEYWORD_KEY(5, 'b', 'k'): keyword = KEYWORD_BREAK; break;
+    case KEYWORD_KEY(5, 'c', 't'): keyword = KEYWORD_CONST; break;
+    case KEYWORD_KEY(5, 'f', 'e'): keyword = KEYWORD_FALSE; break;
+    case KEYWORD_KEY(5, 'f', 't'): keyword = KEYWORD_FLOAT; break;
+    case KEYWORD_KEY(5, 'p', 't'): keyword = KEYWORD_PRINT; break;
+    case KEYWORD_KEY(5, 's', 't'): keyword = KEYWORD_SHORT; break;
+    case KEYWORD_KEY(6, 'd', 'e'): keyword = KEYWORD_DOUBLE; break;
+    case KEYWORD_KEY(6, 'e', 'f'): keyword = KEYWORD_ELSEIF; break;
+    case KEYWORD_KEY(6, 'r', 'n'): keyword = KEYWORD_RETURN; break;
+    case KEYWORD_KEY(6, 's', 'd'): keyword = KEYWORD_SIGNED; break;
+    case KEYWORD_KEY(6, 's', 'g'): keyword = KEYWORD_STRING; break;
+    case KEYWORD_KEY(8, 'c', 'e'): keyword = KEYWORD_CONTINUE; break;
+    case KEYWORD_KEY(8, 'u', 'd'): keyword = KEYWORD_UNSIGNED; break;
+    default:
+        return NULL;
     }
-    return token;
+
+    const KeywordInfo *info = &keywords[keyword];
+    return memcmp(text, info->spelling, length) == 0 ? info : NULL;
 }
 
+// This function identifies keywords or identifiers
+static Token identifier_or_keyword(Lexer *lexer)
+{
+    size_t start = lexer->position;
+    seek(lexer, scan->identifier(lexer->input, start + 1, lexer->length)); // The first character is already known to match
+
+    // The lexeme is a slice of the input; nothing is copied
+    Token token = make_token(TOKEN_IDENTIFIER, start, lexer->position - start);
+
+    // Check if the lexeme is a keyword
+    const KeywordInfo *info = lookup_keyword(lexer->input + start, token.length);
+    if (info != NULL)
+    {
+        token.type = info->type;
+        if (info->type == TOKEN_BOOL)
+            token.bool_value = info->keyword == KEYWORD_TRUE;
+        else
+            token.keyword = info->keyword;
+    }
+
+    return token; // If it's not a keyword, it stays an identifier
+}
 
-// This function identifies numbers
-static Token *number(Lexer *lexer)
+// This function identifies numbers and decodes their value while scanning
+static Token number(Lexer *lexer)
 {
-    char buffer[256] = {0};              // Initialize a buffer to store the number
-    int i = 0;                           // Initialize an index for the buffer
-    while (isdigit(lexer->current_char)) // While the current character is a digit
+    size_t start = lexer->position;
+    seek(lexer, scan->digits(lexer->input, start + 1, lexer->length));
+
+    // Stop accumulating once the value is past INT_MAX; such a literal is an error
+    unsigned long long value = 0;
+    for (size_t i = start; i < lexer->position && value <= INT_MAX; i++)
     {
-        buffer[i++] = lexer->current_char;
-        advance(lexer);
+        value = value * 10 + (unsigned int)(lexer->input[i] - '0');
     }
-    buffer[i] = '\0'; // Null-terminate the buffer
 
-    Token *token = malloc(sizeof(Token)); // Allocate memory for a new token
-    token->type = TOKEN_NUMBER;           // Set the type of the token to a number
-    token->value = strdup(buffer);        // Duplicate the buffer to store the number
+    // A '.' followed by a digit makes this a floating-point literal
+    if (lexer->current_char == '.' && isdigit(peek_char(lexer)))
+    {
+        seek(lexer, scan->digits(lexer->input, lexer->position + 1, lexer->length)); // Skip the '.' and the fraction
+
+        // The input may not be NUL-terminated, so strtod works on a terminated copy
+        size_t length = lexer->position - start;
+        char small[64];
+        char *text = length < sizeof(small) ? small : (char *)malloc(length + 1);
+        memcpy(text, lexer->input + start, length);
+        text[length] = '\0';
 
-    return token; // Return the token
+        Token token = make_token(TOKEN_FLOAT, start, length);
+        token.float_value = strtod(text, NULL);
+        if (text != small)
+        {
+            free(text);
+        }
+        return token;
+    }
+
+    Token token = make_token(TOKEN_NUMBER, start, lexer->position - start);
+    if (value > INT_MAX)
+    {
+        // The statement is rejected rather than run with a different value
+        report_at(lexer, start, "Integer literal out of range");
+        token.type = TOKEN_UNKNOWN;
+        return token;
+    }
+    token.int_value = (int)value;
+    return token;
 }
 
-// This function identifies strings
-static Token *string(Lexer *lexer)
+// This function identifies strings; the token covers the text between the quotes
+static Token string(Lexer *lexer)
 {
-    char buffer[256] = {0};
-    int i = 0;
     advance(lexer); // Skip the opening quote
+    size_t start = lexer->position;
+    size_t position = scan->quote(lexer->input, start, lexer->length);
+    bool has_escapes = false;
 
-    while (lexer->current_char != '"' && lexer->current_char != '\0')
+    // The text is left as it is in the source: an escape only has to be
+    // stepped over here, and the parser decodes the literals that have any
+    while (position < lexer->length && lexer->input[position] == '\\')
     {
-        buffer[i++] = lexer->current_char;
-        advance(lexer);
+        has_escapes = true;
+        position = position + 2 < lexer->length ? position + 2 : lexer->length;
+        position = scan->quote(lexer->input, position, lexer->length);
     }
+    seek(lexer, position);
+
+    Token token = make_token(TOKEN_STRING, start, lexer->position - start);
+    token.has_escapes = has_escapes;
 
     if (lexer->current_char == '"')
     {
@@ -125,20 +250,17 @@ static Token *string(Lexer *lexer)
     }
     else
     {
-        printf("Error: Unterminated string literal\n");
+        report("Error: Unterminated string literal\n");
+        lexer->had_error = true;
     }
 
-    Token *token = malloc(sizeof(Token));
-    token->type = TOKEN_STRING;
-    token->value = strdup(buffer);
-
     return token;
 }
 
 // This function looks at the next character without moving the lexer
 char peek_char(Lexer *lexer)
 {
-    if (lexer->read_position >= strlen(lexer->input))
+    if (lexer->read_position >= lexer->length)
     {
         return '\0'; // Return null if we've reached the end of the input
     }
@@ -190,20 +312,19 @@ static void skip_comments(Lexer *lexer)
     if (lexer->current_char == '/' && peek_char(lexer) == '/')
     {
         // Skip the comment until the end of the line or the end of the input
-        while (lexer->current_char != '\n' && lexer->current_char != '\0')
-        {
-            advance(lexer);
-        }
+        seek(lexer, scan->line_end(lexer->input, lexer->position + 2, lexer->length));
     }
     // If the current character is a '/' and the next character is a '*'
     else if (lexer->current_char == '/' && peek_char(lexer) == '*')
     {
-        advance(lexer); // Skip '/'
-        advance(lexer); // Skip '*'
-        // Skip the comment until the end of the block or the end of the input
-        while (!(lexer->current_char == '*' && peek_char(lexer) == '/'))
+        // Skip "/*" and the comment until the end of the block or the end of the input
+        size_t start = lexer->position;
+        seek(lexer, scan->comment_end(lexer->input, lexer->position + 2, lexer->length));
+        if (lexer->current_char != '*')
         {
-            advance(lexer);
+            // Every scanner stops at the '*' of "*/", so anything else is the end of the input
+            report_at(lexer, start, "Unterminated block comment");
+            return;
         }
         advance(lexer); // Skip '*'
         advance(lexer); // Skip '/'
@@ -213,29 +334,29 @@ static void skip_comments(Lexer *lexer)
 // Skip whitespace characters
 void skip_whitespace(Lexer *lexer)
 {
-    // While the current character is a space, tab, newline, or carriage return
-    while (lexer->current_char == ' ' || lexer->current_char == '\t' || lexer->current_char == '\n' || lexer->current_char == '\r')
+    // Single separators are the common case, so they are checked here before scanning a longer run
+    if (lexer->current_char == ' ' || lexer->current_char == '\t' || lexer->current_char == '\n' || lexer->current_char == '\r')
     {
-        advance(lexer);
+        seek(lexer, scan->whitespace(lexer->input, lexer->position + 1, lexer->length));
     }
 }
 
 
-// Get the next token
-Token *next_token(Lexer *lexer)
+// Scan the next token
+static Token scan_token(Lexer *lexer)
 {
-    // Skip any whitespace and comments
+    // Skip any whitespace and comments (a comment may be followed by more of either)
     skip_whitespace(lexer);
-    skip_comments(lexer);
-
-    Token *token = malloc(sizeof(Token));
-    token->value = NULL;
+    while (lexer->current_char == '/' && (peek_char(lexer) == '/' || peek_char(lexer) == '*'))
+    {
+        skip_comments(lexer);
+        skip_whitespace(lexer);
+    }
 
     // If we've reached the end of the input
     if (lexer->current_char == '\0')
     {
-        token->type = TOKEN_EOF;
-        return token;
+        return make_token(TOKEN_EOF, lexer->position, 0);
     }
 
     // If the current character is alphanumeric or an underscore
@@ -250,14 +371,9 @@ Token *next_token(Lexer *lexer)
         return number(lexer); // Return the token
     }
 
-        // Check for boolean values
-    if ((lexer->current_char == 't' && strncmp(lexer->input + lexer->position, "true", 4) == 0) ||
-        (lexer->current_char == 'f' && strncmp(lexer->input + lexer->position, "false", 5) == 0))
-    {
-        return boolean(lexer);
-    }
+    // Punctuation tokens are one character long unless noted otherwise
+    Token token = make_token(TOKEN_EOF, lexer->position, 1);
 
-    
     // Check for single-character operators and tokens
     switch (lexer->current_char)
     {
@@ -265,37 +381,38 @@ Token *next_token(Lexer *lexer)
         if (peek_char(lexer) == '=')
         {
             advance(lexer);
-            token->type = TOKEN_EQUAL;
+            token.type = TOKEN_EQUAL;
+            token.length = 2;
         }
         else
         {
-            token->type = TOKEN_ASSIGN;
+            token.type = TOKEN_ASSIGN;
         }
         break;
-    case '+': token->type = TOKEN_PLUS; token->value = strdup("+"); break;
-    case '-': token->type = TOKEN_MINUS; token->value = strdup("-"); break;
-    case '%': token->type = TOKEN_MODULUS; token->value = strdup("%"); break;
+    case '+': token.type = TOKEN_PLUS; break;
+    case '-': token.type = TOKEN_MINUS; break;
+    case '%': token.type = TOKEN_MODULUS; break;
     case '*':
         if (peek_char(lexer) == '*')
         {
             advance(lexer); // Consume the second '*'
-            token->type = TOKEN_POWER;
-            token->value = strdup("**");
+            token.type = TOKEN_POWER;
+            token.length = 2;
         }
         else
         {
-            token->type = TOKEN_MULTIPLY;
-            token->value = strdup("*");
+            token.type = TOKEN_MULTIPLY;
         }
         break;
-    case '/': token->type = TOKEN_DIVIDE; token->value = strdup("/"); break;
-    case '(': token->type = TOKEN_LPAREN; token->value = strdup("("); break;
-    case ')': token->type = TOKEN_RPAREN; token->value = strdup(")"); break;
-    case ';': token->type = TOKEN_SEMICOLON; token->value = strdup(";"); break;
+    case '/': token.type = TOKEN_DIVIDE; break;
+    case '(': token.type = TOKEN_LPAREN; break;
+    case ')': token.type = TOKEN_RPAREN; break;
+    case ';': token.type = TOKEN_SEMICOLON; break;
     case '"': return string(lexer);
     default:
-        printf("Unknown character: %c\n", lexer->current_char);
-        token->type = TOKEN_EOF;
+        report("Unknown character: %c\n", lexer->current_char);
+        lexer->had_error = true;
+        token.type = TOKEN_EOF;
         return token;
     }
 
@@ -303,3 +420,16 @@ Token *next_token(Lexer *lexer)
     return token;
 }
 
+// Get the next token
+Token next_token(Lexer *lexer)
+{
+    Token token = scan_token(lexer);
+    TRACE_DEBUG(TRACE_LEXER, "Token type %d: '%.*s'", token.type, (int)token.length, lexer->input + token.start);
+    return token;
+}
+
+// Get the text of a token (a slice of the input, not NUL-terminated)
+const char *token_text(const Lexer *lexer, const Token *token)
+{
+    return lexer->input + token->start;
+}
@@ -1,6 +1,7 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stdbool.h>
 #include <stddef.h> // For size_t
 
 // Token types
@@ -84,16 +85,35 @@ typedef enum
     KEYWORD_SIGNED,
     KEYWORD_DOUBLE,
     KEYWORD_STRING,
-    // Add other keywords here
+    KEYWORD_ECHO,  // Spelling of print
+    KEYWORD_TRUE,  // Boolean literals
+    KEYWORD_FALSE,
+    // Add other keywords here, and to the table in lexer.c
+    KEYWORD_COUNT
 } KeywordType;
 
+// How the lexer classifies one reserved word
+typedef struct
+{
+    const char *spelling;
+    TokenType type;      // Token produced for the word (TOKEN_KEYWORD if the parser has no dedicated type)
+    KeywordType keyword; // Stored in Token.keyword
+} KeywordInfo;
+
 // Token structure
+// Tokens are small values that refer back into the lexer's input buffer
+// instead of owning a copy of their text, so producing one never allocates.
 typedef struct
 {
     TokenType type;
+    size_t start;  // Offset of the lexeme in the input (for strings: just inside the quotes)
+    size_t length; // Length of the lexeme in bytes
     union
     {
-        char *value;         // For identifiers and literals
+        int int_value;       // For TOKEN_NUMBER, decoded while lexing
+        double float_value;  // For TOKEN_FLOAT, decoded while lexing
+        bool bool_value;     // For TOKEN_BOOL
+        bool has_escapes;    // For TOKEN_STRING: the text contains backslash escapes still to be decoded
         KeywordType keyword; // For keywords
     };
 } Token;
@@ -102,9 +122,11 @@ typedef struct
 typedef struct
 {
     const char *input;
+    size_t length;        // Number of bytes in the input
     size_t position;      // Current position in the input
     size_t read_position; // Current reading position in the input
     char current_char;
+    bool had_error;       // Set once an unterminated string or comment, or an unknown character, was reported
 } Lexer;
 
 /**
@@ -115,6 +137,18 @@ typedef struct
  */
 Lexer *init_lexer(const char *input);
 
+/**
+ * @brief Initializes a new lexer over a buffer of known length.
+ *
+ * The buffer does not need to be NUL-terminated; the lexer never reads past
+ * input[length - 1]. The buffer must outlive the lexer and its tokens.
+ *
+ * @param input The source code buffer to be tokenized.
+ * @param length The number of bytes in the buffer.
+ * @return Lexer* A pointer to the newly created Lexer structure.
+ */
+Lexer *init_lexer_n(const char *input, size_t length);
+
 /**
  * @brief Advances the lexer to the next character in the input.
  * 
@@ -134,8 +168,32 @@ char peek_char(Lexer *lexer);
  * @brief Retrieves the next token from the input.
  * 
  * @param lexer A pointer to the Lexer structure.
- * @return Token* A pointer to the next Token in the input.
+ * @return Token The next Token in the input.
+ */
+Token next_token(Lexer *lexer);
+
+/**
+ * @brief Looks up a word in the keyword table.
+ *
+ * The lookup takes constant time however many keywords there are: the
+ * word's length and first and last characters select at most one candidate,
+ * which is then compared once.
+ *
+ * @param text The word (need not be NUL-terminated).
+ * @param length The length of the word in bytes.
+ * @return const KeywordInfo* The keyword's entry, or NULL if the word is an identifier.
+ */
+const KeywordInfo *lookup_keyword(const char *text, size_t length);
+
+/**
+ * @brief Returns a pointer to the first character of a token's lexeme.
+ *
+ * The text is not NUL-terminated; use the token's length.
+ *
+ * @param lexer A pointer to the Lexer that produced the token.
+ * @param token A pointer to the Token.
+ * @return const char* The start of the lexeme inside the lexer's input.
  */
-Token *next_token(Lexer *lexer);
+const char *token_text(const Lexer *lexer, const Token *token);
 
 #endif // LEXER_H
@@ -0,0 +1,305 @@
+#include "scan.h"
+#include <stdint.h>
+
+// Vector routines are only built for x86-64, where SSE2 is always available
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SCAN_X86_64 1
+#include <immintrin.h>
+#else
+#define SCAN_X86_64 0
+#endif
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_identifier_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Scalar versions; the vector versions also use them for the last few bytes of the input
+
+static size_t scalar_whitespace(const char *input, size_t position, size_t length)
+{
+    while (position < length && is_space(input[position]))
+        position++;
+    return position;
+}
+
+static size_t scalar_identifier(const char *input, size_t position, size_t length)
+{
+    while (position < length && is_identifier_char(input[position]))
+        position++;
+    return position;
+}
+
+static size_t scalar_digits(const char *input, size_t position, size_t length)
+{
+    while (position < length && input[position] >= '0' && input[position] <= '9')
+        position++;
+    return position;
+}
+
+static size_t scalar_line_end(const char *input, size_t position, size_t length)
+{
+    while (position < length && input[position] != '\n' && input[position] != '\0')
+        position++;
+    return position;
+}
+
+static size_t scalar_quote(const char *input, size_t position, size_t length)
+{
+    while (position < length && input[position] != '"' && input[position] != '\\' && input[position] != '\0')
+        position++;
+    return position;
+}
+
+static size_t scalar_comment_end(const char *input, size_t position, size_t length)
+{
+    while (position < length && input[position] != '\0' &&
+           !(input[position] == '*' && position + 1 < length && input[position + 1] == '/'))
+        position++;
+    return position;
+}
+
+static const ScanFunctions scalar_functions = {
+    scalar_whitespace, scalar_identifier, scalar_digits, scalar_line_end, scalar_quote, scalar_comment_end,
+};
+
+#if SCAN_X86_64
+
+// Each vector routine builds a bit mask with one bit per byte that ends the
+// run; the lowest set bit is the answer. Full blocks are loaded only while
+// they lie inside the input; smaller blocks and then single bytes finish the tail.
+
+// This function sets the bytes of 'c' that lie in [low, high] (ASCII only: bytes >= 0x80 compare as negative)
+static inline __m128i sse2_in_range(__m128i c, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8((char)(low - 1))),
+                         _mm_cmplt_epi8(c, _mm_set1_epi8((char)(high + 1))));
+}
+
+static size_t sse2_whitespace(const char *input, size_t position, size_t length)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(input + position));
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\r'))));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(space) & 0xFFFFu;
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return scalar_whitespace(input, position, length);
+}
+
+static size_t sse2_identifier(const char *input, size_t position, size_t length)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(input + position));
+        __m128i letter = sse2_in_range(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z'); // Folds upper case onto lower case
+        __m128i digit = sse2_in_range(c, '0', '9');
+        __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)) & 0xFFFFu;
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return scalar_identifier(input, position, length);
+}
+
+static size_t sse2_digits(const char *input, size_t position, size_t length)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(input + position));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(sse2_in_range(c, '0', '9')) & 0xFFFFu;
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return scalar_digits(input, position, length);
+}
+
+// This function finds the first byte equal to 'stop', 'other_stop' or NUL
+static inline size_t sse2_find(const char *input, size_t position, size_t length, char stop, char other_stop)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(input + position));
+        __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(stop)), _mm_cmpeq_epi8(c, _mm_set1_epi8(other_stop))),
+                                     _mm_cmpeq_epi8(c, _mm_setzero_si128()));
+        unsigned mask = (unsigned)_mm_movemask_epi8(found);
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    while (position < length && input[position] != stop && input[position] != other_stop && input[position] != '\0')
+        position++;
+    return position;
+}
+
+static size_t sse2_line_end(const char *input, size_t position, size_t length)
+{
+    return sse2_find(input, position, length, '\n', '\n');
+}
+
+static size_t sse2_quote(const char *input, size_t position, size_t length)
+{
+    return sse2_find(input, position, length, '"', '\\');
+}
+
+static size_t sse2_comment_end(const char *input, size_t position, size_t length)
+{
+    // Every '*' is a candidate; the byte after it decides
+    for (;; position++)
+    {
+        position = sse2_find(input, position, length, '*', '*');
+        if (position >= length || input[position] == '\0')
+            return position;
+        if (position + 1 < length && input[position + 1] == '/')
+            return position;
+    }
+}
+
+static const ScanFunctions sse2_functions = {
+    sse2_whitespace, sse2_identifier, sse2_digits, sse2_line_end, sse2_quote, sse2_comment_end,
+};
+
+// The AVX2 versions are the SSE2 ones with 32-byte blocks. They are compiled
+// for AVX2 individually, so the rest of the program still runs on any x86-64.
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i avx2_in_range(__m256i c, char low, char high)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8((char)(low - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(high + 1)), c));
+}
+
+AVX2 static size_t avx2_whitespace(const char *input, size_t position, size_t length)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(input + position));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r'))));
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(space);
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return sse2_whitespace(input, position, length);
+}
+
+AVX2 static size_t avx2_identifier(const char *input, size_t position, size_t length)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(input + position));
+        __m256i letter = avx2_in_range(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i digit = avx2_in_range(c, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore));
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return sse2_identifier(input, position, length);
+}
+
+AVX2 static size_t avx2_digits(const char *input, size_t position, size_t length)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(input + position));
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(avx2_in_range(c, '0', '9'));
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return sse2_digits(input, position, length);
+}
+
+AVX2 static inline size_t avx2_find(const char *input, size_t position, size_t length, char stop, char other_stop)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(input + position));
+        __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(stop)),
+                                                        _mm256_cmpeq_epi8(c, _mm256_set1_epi8(other_stop))),
+                                        _mm256_cmpeq_epi8(c, _mm256_setzero_si256()));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(found);
+        if (mask)
+            return position + (size_t)__builtin_ctz(mask);
+    }
+    return sse2_find(input, position, length, stop, other_stop);
+}
+
+AVX2 static size_t avx2_line_end(const char *input, size_t position, size_t length)
+{
+    return avx2_find(input, position, length, '\n', '\n');
+}
+
+AVX2 static size_t avx2_quote(const char *input, size_t position, size_t length)
+{
+    return avx2_find(input, position, length, '"', '\\');
+}
+
+AVX2 static size_t avx2_comment_end(const char *input, size_t position, size_t length)
+{
+    for (;; position++)
+    {
+        position = avx2_find(input, position, length, '*', '*');
+        if (position >= length || input[position] == '\0')
+            return position;
+        if (position + 1 < length && input[position + 1] == '/')
+            return position;
+    }
+}
+
+static const ScanFunctions avx2_functions = {
+    avx2_whitespace, avx2_identifier, avx2_digits, avx2_line_end, avx2_quote, avx2_comment_end,
+};
+
+#endif // SCAN_X86_64
+
+// Indexed by ScanLevel; NULL where the build has no such routines
+static const ScanFunctions *const level_functions[SCAN_LEVEL_COUNT] = {
+    [SCAN_SCALAR] = &scalar_functions,
+#if SCAN_X86_64
+    [SCAN_SSE2] = &sse2_functions,
+    [SCAN_AVX2] = &avx2_functions,
+#endif
+};
+
+static ScanLevel best_level = SCAN_SCALAR;
+const ScanFunctions *scan = &scalar_functions;
+
+#if SCAN_X86_64
+// This function picks the routines once, before main() runs, so lexers on any thread see the same choice
+__attribute__((constructor)) static void choose_scan_level(void)
+{
+    __builtin_cpu_init();
+    best_level = __builtin_cpu_supports("avx2") ? SCAN_AVX2 : SCAN_SSE2;
+    scan = level_functions[best_level];
+}
+#endif
+
+ScanLevel scan_best_level(void)
+{
+    return best_level;
+}
+
+bool scan_set_level(ScanLevel level)
+{
+    if (level >= SCAN_LEVEL_COUNT || level > best_level || level_functions[level] == NULL)
+    {
+        return false;
+    }
+    scan = level_functions[level];
+    return true;
+}
+
+const char *scan_level_name(ScanLevel level)
+{
+    static const char *const names[SCAN_LEVEL_COUNT] = {"scalar", "sse2", "avx2"};
+    return level < SCAN_LEVEL_COUNT ? names[level] : "unknown";
+}
@@ -0,0 +1,56 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Instruction sets the scanning routines can use, from slowest to fastest
+typedef enum
+{
+    SCAN_SCALAR, // One byte at a time; available everywhere
+    SCAN_SSE2,   // 16 bytes at a time (x86-64)
+    SCAN_AVX2,   // 32 bytes at a time (x86-64 with AVX2)
+    SCAN_LEVEL_COUNT
+} ScanLevel;
+
+// The scanning routines of one level. Each takes the input, the position to
+// start at and the input's length, and returns the position of the first byte
+// that ends the run (or 'length' if the run reaches the end of the input).
+// They never read past input[length - 1].
+typedef struct
+{
+    size_t (*whitespace)(const char *input, size_t position, size_t length);    // Spaces, tabs, '\n' and '\r'
+    size_t (*identifier)(const char *input, size_t position, size_t length);    // Letters, digits and '_'
+    size_t (*digits)(const char *input, size_t position, size_t length);        // '0' to '9'
+    size_t (*line_end)(const char *input, size_t position, size_t length);      // Stops at '\n' or NUL
+    size_t (*quote)(const char *input, size_t position, size_t length);         // Stops at '"', '\\' or NUL
+    size_t (*comment_end)(const char *input, size_t position, size_t length);   // Stops at "*/" or NUL
+} ScanFunctions;
+
+// The routines the lexer uses; chosen for the CPU when the program starts
+extern const ScanFunctions *scan;
+
+/**
+ * @brief Returns the fastest level the CPU supports.
+ *
+ * @return ScanLevel The level chosen at startup.
+ */
+ScanLevel scan_best_level(void);
+
+/**
+ * @brief Switches the lexer to the routines of another level (used by benchmarks).
+ *
+ * @param level The level to use.
+ * @return bool true on success, false if the CPU or the build does not support the level.
+ */
+bool scan_set_level(ScanLevel level);
+
+/**
+ * @brief Returns the name of a level, e.g. "sse2".
+ *
+ * @param level The level.
+ * @return const char* A static string.
+ */
+const char *scan_level_name(ScanLevel level);
+
+#endif // SCAN_H
@@ -1,10 +1,75 @@
 #include <stdio.h>  // This line includes the standard input/output library
 #include <stdlib.h> // This line includes the standard library for functions like malloc and free
 #include <string.h> // This line includes the string manipulation library
-#include "lexer/lexer.h"           // This includes our custom lexer code
-#include "parser/parser.h"         // This includes our custom parser code
+#include <stdbool.h> // This line includes the boolean type
+#include "core/core.h"             // This includes the library: building and running programs
 #include "codegen/codegen.h"       // This includes our custom code generation code
-#include "interpreter/interpreter.h" // This includes our custom interpreter code
+#include "common/trace.h"          // This includes the debug tracing facility
+#include "runtime/output.h"        // This includes the buffered program output writer
+#include <unistd.h>                // This includes STDOUT_FILENO
+#include <pthread.h>               // This includes the lock that keeps batch output in order
+#include <time.h>                  // This includes the clock used for batch throughput
+#include <sys/wait.h>              // This includes waitpid() for the forked job children
+#include <errno.h>                 // This includes errno, to retry interrupted reads and waits
+#include "common/pool.h"           // This includes the work-stealing thread pool
+#include "common/report.h"         // This includes the per-thread compile messages
+#include "common/source.h"         // This includes the loader used to read manifests
+#include "optimizer/optimizer.h"   // This includes the AST optimizer
+#include "server/server.h"         // This includes the persistent server and its client
+
+// What the driver does with a program once it has been checked
+typedef enum
+{
+    MODE_RUN,    // Execute it with the selected engine (default)
+    MODE_EMIT_C, // Write the generated C source
+    MODE_COMPILE // Build a native executable with the system C compiler
+} DriverMode;
+
+// Options collected from the command line
+typedef struct
+{
+    DriverMode mode;
+    const char *output_path; // -o: the C file or executable to write
+    ExecutionEngine engine;
+    bool dump_bytecode;
+    int opt_level;         // OPT_LEVEL_* selected with -O
+    const char *cache_dir; // --cache-dir: where checked programs are cached (NULL disables the cache)
+    int jobs;              // --jobs: threads used by --batch, or children running at once for --fork-jobs
+    const char **params;   // --param: "name=value" settings for the program's parameters
+    size_t param_count;
+    const char *fork_jobs; // --fork-jobs: the file listing one job per line, or "-" for stdin
+} Options;
+
+// One script of a batch and what running it produced
+typedef struct
+{
+    const char *path;
+    Output *out; // Everything the script printed, compile errors included, until it is emitted
+    bool ok;     // It was built and run
+    bool done;
+} BatchScript;
+
+// A batch being run; workers finish scripts in any order, but they are emitted in input order
+typedef struct
+{
+    BatchScript *scripts;
+    size_t count;
+    const Options *options;
+    pthread_mutex_t lock; // Guards 'done', 'emitted', 'failed' and 'stdout_out'
+    size_t emitted;       // Scripts before this one have been written to stdout
+    size_t failed;
+    Output *stdout_out;
+} Batch;
+
+// A job of --fork-jobs: the child running it and the pipe its output comes through
+typedef struct
+{
+    pid_t pid;
+    int fd;
+} ForkJob;
+
+static bool read_manifest(const char *manifest, char ***paths, size_t *count);
+static bool run_fork_jobs(Program *program, Context *context, const Options *options);
 
 /**
  * @brief Prints the usage instructions for the A++ compiler.
@@ -15,81 +80,549 @@ void print_usage()
 {
     // This function prints instructions on how to use the program
 
-    printf("Usage: ./build/bin/a++c <source_file>.a++\n");
+    printf("Usage: ./build/bin/a++c [options] <source_file>.a++\n");
+    printf("       ./build/bin/a++c [options] -    (read the program from stdin)\n");
+    printf("       ./build/bin/a++c [options] --batch <source_file>.a++...\n");
+    printf("       ./build/bin/a++c [options] --serve=<socket>\n");
+    printf("       ./build/bin/a++c [options] --connect=<socket> <source_file>.a++\n");
+    printf("Options:\n");
+    printf("  --engine=vm       Run on the bytecode VM (default)\n");
+    printf("  --engine=tree     Run with the tree-walking interpreter\n");
+    printf("  --engine=jit      Run with the interpreter, compiling integer arithmetic to native code\n");
+    printf("  --dump-bytecode   Print the compiled bytecode before running it\n");
+    printf("  --emit-c          Write the program as C source (to stdout, or to the -o file)\n");
+    printf("  --compile         Compile the program to a native executable (needs a C compiler, see $CC)\n");
+    printf("  -o <file>         Output file for --emit-c and --compile (default: the source name without .a++)\n");
+    printf("  -O0               Disable optimizations\n");
+    printf("  -O1               Fold constant expressions\n");
+    printf("  -O2               Also simplify identities such as x*1 and x+0 (default)\n");
+    printf("  --cache-dir=<dir> Reuse checked programs from <dir>, skipping lexing and parsing of unchanged scripts\n");
+    printf("  --batch           Run every file given, in parallel; output is printed in input order\n");
+    printf("  --manifest=<file> Run the files listed in <file> (one per line, '#' starts a comment) as a batch\n");
+    printf("  --jobs=<n>        Threads used by a batch, or children run at once by --fork-jobs (default: one per CPU)\n");
+    printf("  --param=<n>=<v>   Start the parameter <n> (a variable declared without a value) at <v>\n");
+    printf("  --fork-jobs=<f>   Build the program once, then run it in a forked child per line of <f> ('-' for stdin);\n");
+    printf("                    each line sets parameters as name=value pairs, overriding --param\n");
+    printf("  --serve=<socket>  Run scripts sent by --connect clients, keeping built programs in memory\n");
+    printf("  --max-programs=<n> Built programs a server keeps (default: %d)\n", SERVER_DEFAULT_MAX_PROGRAMS);
+    printf("  --connect=<socket> Run the program on the server listening on <socket>\n");
+#if TRACE_ENABLED
+    printf("  --trace=<list>    Trace the given categories (lexer,parser,resolver,optimizer,interpreter,vm,codegen,jit,cache or all)\n");
+    printf("  --trace-level=<l> Most detailed trace level: error, warn, info or debug (default)\n");
+    printf("  --trace-file=<f>  Write the trace to a file instead of stderr\n");
+#endif
 }
 
 /**
  * @brief Runs the A++ compiler on the specified file.
  *
- * This function reads the input file, initializes the lexer and parser,
- * generates the AST, and interprets the code.
+ * This function builds the program in the input file (or loads it from the
+ * cache), and interprets or compiles the code.
  *
- * @param filename The path to the .a++ source file to compile and run.
+ * @param filename The path to the .a++ source file to compile and run, or "-" for stdin.
+ * @param options The options selected on the command line.
  */
-void run_file(const char *filename)
+void run_file(const char *filename, const Options *options)
 {
-    // This function opens the source file, reads its contents, and prepares for compilation
+    // This function loads the source file and prepares for compilation
 
-    // Open the file for reading
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    // Lex, parse, resolve, type-check and optimize the program (errors are already reported)
+    BuildOptions build = {options->opt_level, options->cache_dir};
+    Program *program = load_program(filename, &build);
+    if (program == NULL)
     {
-        // If the file couldn't be opened, print an error message and exit
-        printf("Error: Could not open file '%s'.\n", filename);
         exit(1);
     }
 
-    // Move to the end of the file to determine its size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
+    if (options->mode != MODE_RUN)
+    {
+        bool ok;
+        if (options->mode == MODE_EMIT_C)
+        {
+            // Translate to C instead of running the program
+            FILE *c_file = options->output_path ? fopen(options->output_path, "w") : stdout;
+            if (c_file == NULL)
+            {
+                printf("Error: Could not open file '%s' for writing.\n", options->output_path);
+                ok = false;
+            }
+            else
+            {
+                ok = generate_code(program->ast, c_file);
+                if (c_file != stdout)
+                {
+                    ok = fclose(c_file) == 0 && ok;
+                }
+            }
+        }
+        else
+        {
+            // Build a native executable through the system C compiler
+            ok = compile_to_executable(program->ast, options->output_path);
+        }
 
-    // Move back to the start of the file
-    fseek(file, 0, SEEK_SET);
+        free_program(program);
+        if (!ok)
+        {
+            printf("Error: Failed to compile the source file.\n");
+            exit(1);
+        }
+        return;
+    }
 
-    // Allocate memory for the source code
-    char *source_code = (char *)malloc(file_size + 1);
-    if (!source_code)
+    // Compile the program for the selected engine (bytecode, or native code for the JIT)
+    Context *context = create_context(program, options->engine);
+    if (context == NULL)
     {
-        // If memory allocation fails, print an error message and exit
-        printf("Error: Failed to allocate memory for source code.\n");
-        fclose(file);
+        free_program(program);
         exit(1);
     }
 
-    // Read the entire file into the allocated memory
-    size_t read_size = fread(source_code, 1, file_size, file);
-    source_code[read_size] = '\0'; // Add a null terminator to the end of the string
+    // Parameters given on the command line apply to every run (and every job)
+    for (size_t i = 0; i < options->param_count; i++)
+    {
+        const char *equals = strchr(options->params[i], '=');
+        char *name = strndup(options->params[i], (size_t)(equals - options->params[i]));
+        bool set = set_context_parameter(context, name, equals + 1);
+        free(name);
+        if (!set)
+        {
+            free_context(context);
+            free_program(program);
+            exit(1);
+        }
+    }
 
-    // Close the file as we're done reading from it
-    fclose(file);
+    if (options->dump_bytecode && context->chunk != NULL)
+    {
+        disassemble_chunk(context->chunk);
+    }
 
-    // Initialize the lexer with the source code
-    Lexer *lexer = init_lexer(source_code);
+    if (options->fork_jobs != NULL)
+    {
+        bool ok = run_fork_jobs(program, context, options);
+        free_context(context);
+        free_program(program);
+        if (!ok)
+        {
+            exit(1);
+        }
+        return;
+    }
 
-    // Create a parser using the lexer
-    Parser *parser = create_parser(lexer);
+    // Program output is buffered separately from stdio; flush anything printf'd
+    // so far (such as lexer warnings) so it appears before the program's output
+    fflush(stdout);
+    Output *out = create_output(STDOUT_FILENO);
+    run_context(context, out);
 
-    // Parse the tokens to create an Abstract Syntax Tree (AST)
-    ASTNode *ast = parse_tokens(parser);
+    // Write out whatever the program printed, then clean up: free all allocated memory
+    free_output(out);
+    free_context(context);
+    free_program(program);
+}
 
-    if (ast == NULL)
+// This function reports whether a path names an A++ source file (or stdin)
+static bool has_source_extension(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    return strcmp(path, "-") == 0 || (ext && strcmp(ext, ".a++") == 0);
+}
+
+// This function builds and runs one script of a batch into its own buffer, then
+// writes out every script at the front of the batch that has finished
+static void run_batch_script(void *context, size_t index, int worker)
+{
+    (void)worker;
+    Batch *batch = (Batch *)context;
+    BatchScript *script = &batch->scripts[index];
+    const Options *options = batch->options;
+
+    // Compile errors go to the script's buffer too, so they stay next to its output
+    Output *out = create_memory_output();
+    set_report_output(out);
+    if (!has_source_extension(script->path))
+    {
+        report("Error: Input file must have a .a++ extension.\n");
+    }
+    else
+    {
+        BuildOptions build = {options->opt_level, options->cache_dir};
+        Program *program = load_program(script->path, &build);
+        Context *run = program ? create_context(program, options->engine) : NULL;
+        script->ok = run != NULL && run_context(run, out);
+        free_context(run);
+        free_program(program);
+    }
+    set_report_output(NULL);
+    script->out = out;
+
+    pthread_mutex_lock(&batch->lock);
+    script->done = true;
+    while (batch->emitted < batch->count && batch->scripts[batch->emitted].done)
+    {
+        BatchScript *next = &batch->scripts[batch->emitted++];
+        output_string(batch->stdout_out, "==> ");
+        output_string(batch->stdout_out, next->path);
+        output_string(batch->stdout_out, " <==");
+        output_newline(batch->stdout_out);
+        output_write(batch->stdout_out, next->out->buffer, next->out->length);
+        free_output(next->out);
+        next->out = NULL;
+        if (!next->ok)
+        {
+            batch->failed++;
+        }
+    }
+    pthread_mutex_unlock(&batch->lock);
+}
+
+/**
+ * @brief Runs many scripts at once on a pool of threads.
+ *
+ * Each script gets its own program, context and output buffer. Its output
+ * (and any compile errors) is printed under a "==> path <==" line, in the
+ * order the scripts were given, as soon as every script before it is done.
+ * The number of scripts per second is reported on stderr.
+ *
+ * @param paths The scripts to run.
+ * @param count The number of scripts.
+ * @param options The options selected on the command line.
+ * @return bool true if every script was built and run.
+ */
+static bool run_batch(const char *const *paths, size_t count, const Options *options)
+{
+    Batch batch = {NULL, count, options, PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL};
+    batch.scripts = (BatchScript *)calloc(count ? count : 1, sizeof(BatchScript));
+    if (!batch.scripts)
     {
-        // If parsing failed, print an error message
-        printf("Error: Failed to parse the source file.\n");
-        free_parser(parser);
-        free(lexer);
-        free(source_code);
+        printf("Error: Failed to allocate memory for the batch.\n");
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        batch.scripts[i].path = paths[i];
+    }
+
+    int jobs = options->jobs;
+    if (jobs < 1)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int)cpus : 1;
+    }
+#if TRACE_ENABLED
+    // The trace sink is shared, so traced batches run one script at a time
+    if (trace_categories != 0)
+    {
+        jobs = 1;
+    }
+#endif
+
+    fflush(stdout);
+    batch.stdout_out = create_output(STDOUT_FILENO);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_pool(count, jobs, run_batch_script, &batch);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free_output(batch.stdout_out);
+
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+    int threads = (size_t)jobs < count ? jobs : (count > 0 ? (int)count : 1);
+    fprintf(stderr, "Batch: %zu scripts (%zu failed) in %.3f s, %.0f scripts/s on %d thread%s\n", count,
+            batch.failed, seconds, seconds > 0 ? (double)count / seconds : 0.0, threads, threads == 1 ? "" : "s");
+
+    bool ok = batch.failed == 0;
+    pthread_mutex_destroy(&batch.lock);
+    free(batch.scripts);
+    return ok;
+}
+
+/**
+ * @brief Reads the script paths listed in a manifest file, or the jobs of --fork-jobs.
+ *
+ * Each non-empty line is one path (or job); leading and trailing blanks are ignored,
+ * and lines starting with '#' are comments.
+ *
+ * @param manifest The path of the manifest, or "-" for stdin.
+ * @param paths Receives the paths, which are appended (the array grows as needed).
+ * @param count The number of paths in 'paths', updated.
+ * @return bool true on success, false if the manifest could not be read.
+ */
+static bool read_manifest(const char *manifest, char ***paths, size_t *count)
+{
+    SourceFile file;
+    if (!load_source_file(manifest, &file))
+    {
+        printf("Error: Could not open file '%s'.\n", manifest);
+        return false;
+    }
+
+    size_t capacity = *count;
+    const char *p = file.data;
+    const char *end = file.data + file.length;
+    while (p < end)
+    {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        if (line_end == NULL)
+        {
+            line_end = end;
+        }
+        const char *first = p;
+        const char *last = line_end;
+        while (first < last && (*first == ' ' || *first == '\t'))
+        {
+            first++;
+        }
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+        {
+            last--;
+        }
+        p = line_end + 1;
+        if (first == last || *first == '#')
+        {
+            continue;
+        }
+
+        if (*count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            char **grown = (char **)realloc(*paths, capacity * sizeof(char *));
+            if (!grown)
+            {
+                printf("Error: Failed to allocate memory for the batch.\n");
+                exit(1);
+            }
+            *paths = grown;
+        }
+        (*paths)[(*count)++] = strndup(first, (size_t)(last - first));
+    }
+
+    release_source_file(&file);
+    return true;
+}
+
+// This function sets one job's parameters, written as name=value pairs separated
+// by blanks; a value in double quotes may contain blanks. The line is split in place.
+static bool apply_job_parameters(Context *context, char *job)
+{
+    char *p = job;
+    for (;;)
+    {
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            return true;
+        }
+
+        char *name = p;
+        while (*p != '\0' && *p != '=' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+        if (*p != '=' || p == name)
+        {
+            report("Error: Job parameters are written as name=value, not '%.*s'.\n", (int)strcspn(name, " \t"), name);
+            return false;
+        }
+        *p++ = '\0';
+
+        char *value = p;
+        if (*p == '"')
+        {
+            value = ++p;
+            while (*p != '\0' && *p != '"')
+            {
+                p++;
+            }
+            if (*p != '"')
+            {
+                report("Error: Unterminated string in the value of parameter '%s'.\n", name);
+                return false;
+            }
+        }
+        else
+        {
+            while (*p != '\0' && *p != ' ' && *p != '\t')
+            {
+                p++;
+            }
+        }
+        if (*p != '\0')
+        {
+            *p++ = '\0';
+        }
+
+        if (!set_context_parameter(context, name, value))
+        {
+            return false;
+        }
+    }
+}
+
+// This function starts the child for one job. The child shares the built program
+// with the parent copy-on-write, sets the job's parameters, runs the program into
+// a pipe and exits; it never returns.
+static ForkJob start_fork_job(Context *context, char *job)
+{
+    ForkJob child = {-1, -1};
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return child;
+    }
+
+    child.pid = fork();
+    if (child.pid == 0)
+    {
+        close(fds[0]);
+        Output *out = create_output(fds[1]);
+        set_report_output(out);
+        bool ok = apply_job_parameters(context, job) && run_context(context, out);
+        set_report_output(NULL);
+        free_output(out);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if (child.pid < 0)
+    {
+        close(fds[0]);
+        return child;
+    }
+    child.fd = fds[0];
+    return child;
+}
+
+// This function copies a finished job's output to 'out' and collects the child; it returns true if the job succeeded
+static bool finish_fork_job(ForkJob child, Output *out)
+{
+    if (child.pid < 0)
+    {
+        output_string(out, "Error: Could not start a child process for the job.");
+        output_newline(out);
+        return false;
+    }
+
+    char block[65536];
+    ssize_t got;
+    while ((got = read(child.fd, block, sizeof(block))) != 0)
+    {
+        if (got > 0)
+        {
+            output_write(out, block, (size_t)got);
+        }
+        else if (errno != EINTR)
+        {
+            break;
+        }
+    }
+    close(child.fd);
+
+    int status = 0;
+    pid_t waited;
+    while ((waited = waitpid(child.pid, &status, 0)) < 0 && errno == EINTR)
+    {
+    }
+    if (waited < 0)
+    {
+        output_string(out, "Error: Could not wait for the job's child process.");
+        output_newline(out);
+        return false;
+    }
+    if (WIFSIGNALED(status))
+    {
+        char message[64];
+        snprintf(message, sizeof(message), "Error: The job was killed by signal %d.", WTERMSIG(status));
+        output_string(out, message);
+        output_newline(out);
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * @brief Runs a built program once per job, each in a forked child.
+ *
+ * The program is built and compiled once, then frozen (see freeze_program()),
+ * so every child starts with the AST and the engine's code already in memory,
+ * shared copy-on-write, and only dirties its own variables. Each job's output,
+ * including parameter errors, is printed under a "==> <job> <==" line in the
+ * order of the jobs. Up to --jobs children run at once. The number of jobs
+ * per second is reported on stderr.
+ *
+ * @param program The built program.
+ * @param context The context to run it in, with the --param values set.
+ * @param options The options selected on the command line.
+ * @return bool true if every job ran.
+ */
+static bool run_fork_jobs(Program *program, Context *context, const Options *options)
+{
+    char **jobs = NULL;
+    size_t count = 0;
+    if (!read_manifest(options->fork_jobs, &jobs, &count))
+    {
+        return false;
+    }
+    ForkJob *children = (ForkJob *)calloc(count ? count : 1, sizeof(ForkJob));
+    if (!children)
+    {
+        printf("Error: Failed to allocate memory for the jobs.\n");
         exit(1);
     }
 
-    // Interpret the AST (execute the program)
-    interpret(ast);
+    size_t max_children = options->jobs;
+    if (max_children < 1)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_children = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    // From here on a write into the AST faults instead of copying pages in every child
+    freeze_program(program);
+    fflush(stdout);
+    Output *out = create_output(STDOUT_FILENO);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Keep up to max_children running; output is copied in job order, so a later
+    // child with more output than a pipe holds waits until it is its turn
+    size_t started = 0;
+    size_t failed = 0;
+    for (size_t next = 0; next < count; next++)
+    {
+        while (started < count && started - next < max_children)
+        {
+            children[started] = start_fork_job(context, jobs[started]);
+            started++;
+        }
+
+        output_string(out, "==> ");
+        output_string(out, jobs[next]);
+        output_string(out, " <==");
+        output_newline(out);
+        if (!finish_fork_job(children[next], out))
+        {
+            failed++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free_output(out);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+    size_t processes = max_children < count ? max_children : (count > 0 ? count : 1);
+    fprintf(stderr, "Fork jobs: %zu jobs (%zu failed) in %.3f s, %.0f jobs/s on %zu process%s\n", count, failed,
+            seconds, seconds > 0 ? (double)count / seconds : 0.0, processes, processes == 1 ? "" : "es");
 
-    // Clean up: free all allocated memory
-    free_parser(parser);
-    free_ast(ast);
-    free(lexer);
-    free(source_code);
+    for (size_t i = 0; i < count; i++)
+    {
+        free(jobs[i]);
+    }
+    free(jobs);
+    free(children);
+    return failed == 0;
 }
 
 /**
@@ -104,25 +637,270 @@ void run_file(const char *filename)
 int main(int argc, char *argv[])
 {
     // This is the main function, the entry point of the program
-    if (argc != 2)
+    Options options = {MODE_RUN, NULL, ENGINE_VM, false, OPT_LEVEL_DEFAULT, NULL, 0, NULL, 0, NULL};
+    const char *filename = NULL;
+    const char *files[argc]; // Every file named, for --batch
+    const char *params[argc]; // Every --param given
+    size_t file_count = 0;
+    bool batch = false;
+    const char *manifest = NULL;
+    ServerOptions server = {NULL, SERVER_DEFAULT_MAX_PROGRAMS, NULL};
+    const char *connect_socket = NULL;
+    const char *trace_list = NULL;
+    const char *trace_file = NULL;
+    TraceLevel level = TRACE_LEVEL_DEBUG;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--engine=vm") == 0)
+        {
+            options.engine = ENGINE_VM;
+        }
+        else if (strcmp(argv[i], "--engine=tree") == 0)
+        {
+            options.engine = ENGINE_TREE;
+        }
+        else if (strcmp(argv[i], "--engine=jit") == 0)
+        {
+            options.engine = ENGINE_JIT;
+        }
+        else if (strcmp(argv[i], "--emit-c") == 0)
+        {
+            options.mode = MODE_EMIT_C;
+        }
+        else if (strcmp(argv[i], "--compile") == 0)
+        {
+            options.mode = MODE_COMPILE;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            options.output_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--dump-bytecode") == 0)
+        {
+            options.dump_bytecode = true;
+        }
+        else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '9' && argv[i][3] == '\0')
+        {
+            // Levels above the highest one behave like the highest one
+            options.opt_level = argv[i][2] - '0';
+            if (options.opt_level > OPT_LEVEL_SIMPLIFY)
+            {
+                options.opt_level = OPT_LEVEL_SIMPLIFY;
+            }
+        }
+        else if (strncmp(argv[i], "--cache-dir=", 12) == 0 && argv[i][12] != '\0')
+        {
+            options.cache_dir = argv[i] + 12;
+        }
+        else if (strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            trace_list = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--trace-level=", 14) == 0)
+        {
+            if (!trace_parse_level(argv[i] + 14, &level))
+            {
+                printf("Error: Unknown trace level '%s'.\n", argv[i] + 14);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--trace-file=", 13) == 0)
+        {
+            trace_file = argv[i] + 13;
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+        {
+            batch = true;
+        }
+        else if (strncmp(argv[i], "--manifest=", 11) == 0 && argv[i][11] != '\0')
+        {
+            manifest = argv[i] + 11;
+        }
+        else if (strncmp(argv[i], "--jobs=", 7) == 0)
+        {
+            options.jobs = atoi(argv[i] + 7);
+            if (options.jobs < 1)
+            {
+                printf("Error: --jobs needs a positive number of threads.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--param=", 8) == 0 && argv[i][8] != '=' && strchr(argv[i] + 8, '=') != NULL)
+        {
+            params[options.param_count++] = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--fork-jobs=", 12) == 0 && argv[i][12] != '\0')
+        {
+            options.fork_jobs = argv[i] + 12;
+        }
+        else if (strncmp(argv[i], "--serve=", 8) == 0 && argv[i][8] != '\0')
+        {
+            server.socket_path = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--max-programs=", 15) == 0)
+        {
+            int max_programs = atoi(argv[i] + 15);
+            if (max_programs < 1)
+            {
+                printf("Error: --max-programs needs a positive number of programs.\n");
+                return 1;
+            }
+            server.max_programs = (size_t)max_programs;
+        }
+        else if (strncmp(argv[i], "--connect=", 10) == 0 && argv[i][10] != '\0')
+        {
+            connect_socket = argv[i] + 10;
+        }
+        else if (argv[i][0] == '-' && argv[i][1] != '\0')
+        {
+            // Unknown options and extra arguments are usage errors
+            print_usage();
+            return 1;
+        }
+        else
+        {
+            filename = argv[i]; // Get the filename from the command line argument
+            files[file_count++] = argv[i];
+        }
+    }
+
+    if (!batch && manifest == NULL && file_count > 1)
     {
-        // If the wrong number of arguments is provided, print usage instructions and exit
+        // Only a batch takes more than one file
         print_usage();
         return 1;
     }
 
-    const char *filename = argv[1];           // Get the filename from the command line argument
+    if (filename == NULL && manifest == NULL && server.socket_path == NULL)
+    {
+        // If no file was provided, print usage instructions and exit
+        print_usage();
+        return 1;
+    }
+
+    if (trace_list != NULL)
+    {
+#if TRACE_ENABLED
+        if (!trace_configure(trace_list, level, trace_file))
+        {
+            printf("Error: Invalid trace configuration '%s'.\n", trace_list);
+            return 1;
+        }
+#else
+        (void)trace_file;
+        (void)level;
+        printf("Error: Tracing is not available in this build (rebuild with 'make debug').\n");
+        return 1;
+#endif
+    }
+
+    if (server.socket_path != NULL)
+    {
+        // A server takes its scripts from clients; the engine and -O come with each request
+        if (filename != NULL || manifest != NULL || batch || connect_socket != NULL || options.mode != MODE_RUN ||
+            options.param_count > 0 || options.fork_jobs != NULL)
+        {
+            print_usage();
+            return 1;
+        }
+        server.cache_dir = options.cache_dir;
+        return run_server(&server);
+    }
+
+    options.params = params;
+    if ((options.param_count > 0 || options.fork_jobs != NULL) &&
+        (batch || manifest != NULL || connect_socket != NULL || options.mode != MODE_RUN))
+    {
+        printf("Error: --param and --fork-jobs only apply to running a single program.\n");
+        return 1;
+    }
+    if (options.fork_jobs != NULL && strcmp(options.fork_jobs, "-") == 0 && strcmp(filename, "-") == 0)
+    {
+        printf("Error: The program and the jobs cannot both be read from stdin.\n");
+        return 1;
+    }
+
+    if (batch || manifest != NULL)
+    {
+        if (options.mode != MODE_RUN || options.dump_bytecode)
+        {
+            printf("Error: A batch can only run programs (not --emit-c, --compile or --dump-bytecode).\n");
+            return 1;
+        }
+
+        // Files named on the command line come first, then the manifest's
+        char **paths = (char **)malloc((file_count ? file_count : 1) * sizeof(char *));
+        size_t path_count = 0;
+        if (!paths)
+        {
+            printf("Error: Failed to allocate memory for the batch.\n");
+            return 1;
+        }
+        for (size_t i = 0; i < file_count; i++)
+        {
+            paths[path_count++] = strdup(files[i]);
+        }
+        bool ok = manifest == NULL || read_manifest(manifest, &paths, &path_count);
+        ok = ok && run_batch((const char *const *)paths, path_count, &options);
+
+        for (size_t i = 0; i < path_count; i++)
+        {
+            free(paths[i]);
+        }
+        free(paths);
+        return ok ? 0 : 1;
+    }
+
     const char *ext = strrchr(filename, '.'); // Get the file extension
 
-    if (!ext || strcmp(ext, ".a++") != 0)
+    if (!has_source_extension(filename))
     {
         // If the file doesn't have a .a++ extension, print an error message and exit
         printf("Error: Input file must have a .a++ extension.\n");
         return 1;
     }
 
+    if (connect_socket != NULL)
+    {
+        if (options.mode != MODE_RUN || options.dump_bytecode)
+        {
+            printf("Error: A server can only run programs (not --emit-c, --compile or --dump-bytecode).\n");
+            return 1;
+        }
+
+        // The server builds (or reuses) the program and runs it; print what it printed
+        ServerReply reply;
+        if (!request_run(connect_socket, filename, options.engine, options.opt_level, &reply))
+        {
+            return 1;
+        }
+        fflush(stdout);
+        Output *out = create_output(STDOUT_FILENO);
+        output_write(out, reply.output, reply.output_length);
+        free_output(out);
+        free_server_reply(&reply);
+        return reply.status;
+    }
+
+    // A native executable is named after its source file unless -o says otherwise
+    char *default_output = NULL;
+    if (options.mode == MODE_COMPILE && options.output_path == NULL)
+    {
+        if (strcmp(filename, "-") == 0)
+        {
+            options.output_path = "a.out";
+        }
+        else
+        {
+            default_output = strndup(filename, (size_t)(ext - filename));
+            options.output_path = default_output;
+        }
+    }
+
     // Run the compiler on the provided file
-    run_file(filename);
+    run_file(filename, &options);
+    free(default_output);
 
     return 0; // Return 0 to indicate successful execution
 }
@@ -0,0 +1,225 @@
+#include "optimizer.h"
+#include "common/report.h"
+#include "common/trace.h"
+#include "common/intmath.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// State carried through one optimization pass
+typedef struct
+{
+    int level;
+    size_t folded;            // Number of operator nodes replaced by a constant
+    size_t simplified;        // Number of identities removed
+    bool had_error;
+} Optimizer;
+
+// This function reports whether 'node' is the integer literal 'value'
+static bool is_int_constant(const ASTNode *node, int value)
+{
+    return node->type == NODE_INT_LITERAL && node->int_value == value;
+}
+
+// This function reports whether an expression produces an integer, as annotated by the type checker
+static bool is_int_expression(const ASTNode *node)
+{
+    return node->value_type == INT_TYPE;
+}
+
+// This function reports whether an expression is an integer expression that can
+// never raise a runtime error, so it is safe to drop without evaluating it
+static bool is_pure_int_expression(const ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_INT_LITERAL:
+        return true;
+    case NODE_LITERAL:
+        return is_int_expression(node);
+    case NODE_BINARY_OP:
+        // Division and modulus may report a zero divisor, and '**' an overflow, at run time
+        if (node->op == BINOP_DIV || node->op == BINOP_MOD || node->op == BINOP_POW)
+            return false;
+        return is_pure_int_expression(node->left) && is_pure_int_expression(node->right);
+    default:
+        return false;
+    }
+}
+
+// This function computes 'left op right' exactly as the execution engines do.
+// It returns false for operations that must be left for run time.
+static bool fold_operator(BinaryOperator op, int left, int right, int *result)
+{
+    // The engines compute with the same intmath.h helpers, so folding cannot change a result
+    switch (op)
+    {
+    case BINOP_ADD:
+        *result = int_add(left, right);
+        return true;
+    case BINOP_SUB:
+        *result = int_sub(left, right);
+        return true;
+    case BINOP_MUL:
+        *result = int_mul(left, right);
+        return true;
+    case BINOP_DIV:
+    case BINOP_MOD:
+        // A zero divisor is reported, at compile or run time
+        if (right == 0)
+            return false;
+        *result = op == BINOP_DIV ? int_div(left, right) : int_mod(left, right);
+        return true;
+    case BINOP_POW:
+        // An overflowing power is left for run time, where it is reported
+        return int_pow(left, right, result);
+    default:
+        return false;
+    }
+}
+
+// This function turns an operator node into an integer literal in place
+static void replace_with_constant(ASTNode *node, int value)
+{
+    node->type = NODE_INT_LITERAL;
+    node->left = NULL;
+    node->right = NULL;
+    node->int_value = value;
+}
+
+// This function counts a removed identity and passes on the replacement node
+static ASTNode *simplified(Optimizer *optimizer, ASTNode *replacement)
+{
+    optimizer->simplified++;
+    return replacement;
+}
+
+// This function applies algebraic identities to an operator node whose operands are
+// already optimized, and returns the node that should take its place
+static ASTNode *simplify_identity(Optimizer *optimizer, ASTNode *node)
+{
+    ASTNode *left = node->left;
+    ASTNode *right = node->right;
+
+    switch (node->op)
+    {
+    case BINOP_ADD:
+        if (is_int_constant(right, 0) && is_int_expression(left))
+            return simplified(optimizer, left); // x + 0
+        if (is_int_constant(left, 0) && is_int_expression(right))
+            return simplified(optimizer, right); // 0 + x
+        break;
+    case BINOP_SUB:
+        if (is_int_constant(right, 0) && is_int_expression(left))
+            return simplified(optimizer, left); // x - 0
+        break;
+    case BINOP_MUL:
+        if (is_int_constant(right, 1) && is_int_expression(left))
+            return simplified(optimizer, left); // x * 1
+        if (is_int_constant(left, 1) && is_int_expression(right))
+            return simplified(optimizer, right); // 1 * x
+        if ((is_int_constant(right, 0) && is_pure_int_expression(left)) ||
+            (is_int_constant(left, 0) && is_pure_int_expression(right)))
+        {
+            replace_with_constant(node, 0); // x * 0, 0 * x
+            return simplified(optimizer, node);
+        }
+        break;
+    case BINOP_DIV:
+        if (is_int_constant(right, 1) && is_int_expression(left))
+            return simplified(optimizer, left); // x / 1
+        break;
+    case BINOP_MOD:
+        if (is_int_constant(right, 1) && is_pure_int_expression(left))
+        {
+            replace_with_constant(node, 0); // x % 1
+            return simplified(optimizer, node);
+        }
+        break;
+    case BINOP_POW:
+        if (is_int_constant(right, 1) && is_int_expression(left))
+            return simplified(optimizer, left); // x ** 1
+        if ((is_int_constant(right, 0) && is_pure_int_expression(left)) ||
+            (is_int_constant(left, 1) && is_pure_int_expression(right)))
+        {
+            replace_with_constant(node, 1); // x ** 0, 1 ** x
+            return simplified(optimizer, node);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return node;
+}
+
+// This function optimizes an expression bottom-up and returns the node that replaces it
+static ASTNode *optimize_expression(Optimizer *optimizer, ASTNode *node)
+{
+    if (node == NULL || node->type != NODE_BINARY_OP)
+    {
+        return node;
+    }
+
+    node->left = optimize_expression(optimizer, node->left);
+    node->right = optimize_expression(optimizer, node->right);
+
+    // Every statement runs, so a constant zero divisor is always a runtime error
+    if ((node->op == BINOP_DIV || node->op == BINOP_MOD) && is_int_constant(node->right, 0))
+    {
+        report("Error: %s by zero.\n", node->op == BINOP_DIV ? "Division" : "Modulus");
+        optimizer->had_error = true;
+        return node;
+    }
+
+    if (node->left->type == NODE_INT_LITERAL && node->right->type == NODE_INT_LITERAL)
+    {
+        int result;
+        if (fold_operator(node->op, node->left->int_value, node->right->int_value, &result))
+        {
+            TRACE_DEBUG(TRACE_OPTIMIZER, "Folded %d %s %d to %d", node->left->int_value,
+                        binary_operator_name(node->op), node->right->int_value, result);
+            replace_with_constant(node, result);
+            optimizer->folded++;
+            return node;
+        }
+    }
+
+    if (optimizer->level >= OPT_LEVEL_SIMPLIFY)
+    {
+        return simplify_identity(optimizer, node);
+    }
+
+    return node;
+}
+
+// This function optimizes every statement in program order
+bool optimize_program(ASTNode *node, int level)
+{
+    if (level <= OPT_LEVEL_NONE)
+    {
+        return true;
+    }
+
+    Optimizer optimizer;
+    memset(&optimizer, 0, sizeof(optimizer));
+    optimizer.level = level;
+
+    for (; node != NULL; node = node->next)
+    {
+        switch (node->type)
+        {
+        case NODE_VAR_DECLARATION:
+        case NODE_ASSIGNMENT:
+        case NODE_PRINT:
+            node->left = optimize_expression(&optimizer, node->left);
+            break;
+        default:
+            break;
+        }
+    }
+
+    TRACE_INFO(TRACE_OPTIMIZER, "Folded %zu operators, removed %zu identities", optimizer.folded, optimizer.simplified);
+    return !optimizer.had_error;
+}
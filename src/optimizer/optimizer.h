@@ -0,0 +1,32 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast/ast.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Optimization levels selected with -O on the command line
+#define OPT_LEVEL_NONE 0     // Leave the AST exactly as parsed
+#define OPT_LEVEL_FOLD 1     // Fold constant subexpressions
+#define OPT_LEVEL_SIMPLIFY 2 // Also apply algebraic identities (x*1, x+0, x**1)
+#define OPT_LEVEL_DEFAULT OPT_LEVEL_SIMPLIFY
+
+/**
+ * @brief Rewrites the expressions of a type-checked program in place.
+ *
+ * Runs between type checking and execution, so every engine sees the
+ * optimized tree. Constant subexpressions are replaced by integer literals
+ * with the same wrap-around results the engines would compute, and at
+ * OPT_LEVEL_SIMPLIFY identities are removed as long as dropping an operand
+ * cannot hide a runtime error. Every statement executes, so a division or
+ * modulus by a constant zero is reported here instead of at run time.
+ *
+ * Replacement nodes keep their type annotations.
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param level The optimization level (OPT_LEVEL_*).
+ * @return bool true on success, false if a division by zero was found.
+ */
+bool optimize_program(ASTNode *node, int level);
+
+#endif // OPTIMIZER_H
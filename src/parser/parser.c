@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <string.h>
 #include "parser.h"
+#include "common/report.h"
+#include "common/trace.h"
 #include <limits.h>
 
 // These are function declarations. They tell the compiler that these functions will be defined later.
@@ -19,18 +21,80 @@ static ASTNode *parse_var_declaration(Parser *parser);
 // This function is used to get the next token from the lexer
 static Token *get_next_token(Parser *parser)
 {
-    // If there's a current token, free its memory
-    if (parser->current_token)
+    // Tokens are plain values that point into the source, so there is nothing to free
+    parser->current_token = next_token(parser->lexer);
+    return &parser->current_token;
+}
+
+// This function interns the current token's text, so each distinct name or string is stored once
+static const char *token_string(Parser *parser)
+{
+    return intern_string(parser->strings, token_text(parser->lexer, &parser->current_token), parser->current_token.length);
+}
+
+// This function decodes the escape sequences of a string literal into 'out', which
+// must hold 'length' bytes (decoding never makes the text longer)
+static bool decode_escapes(const char *text, size_t length, char *out, size_t *out_length)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++)
     {
-        if (parser->current_token->value)
+        if (text[i] != '\\')
         {
-            free(parser->current_token->value);
+            out[n++] = text[i];
+            continue;
+        }
+
+        char c = ++i < length ? text[i] : '\0';
+        switch (c)
+        {
+        case 'n': out[n++] = '\n'; break;
+        case 't': out[n++] = '\t'; break;
+        case 'r': out[n++] = '\r'; break;
+        case '\\': out[n++] = '\\'; break;
+        case '"': out[n++] = '"'; break;
+        default:
+            report("Error: Unknown escape sequence '\\%c' in string literal.\n", c ? c : '0');
+            return false;
         }
-        free(parser->current_token);
     }
-    // Get the next token from the lexer and return it
-    parser->current_token = next_token(parser->lexer);
-    return parser->current_token;
+    *out_length = n;
+    return true;
+}
+
+// This function turns the current string token into a literal node. Most literals
+// have no escapes and are interned straight from the source; only the others are
+// decoded, so even very long literals are copied once.
+static ASTNode *parse_string_literal(Parser *parser)
+{
+    const char *text = token_text(parser->lexer, &parser->current_token);
+    size_t length = parser->current_token.length;
+    const char *value;
+
+    if (!parser->current_token.has_escapes)
+    {
+        value = intern_string(parser->strings, text, length);
+    }
+    else
+    {
+        char *decoded = malloc(length ? length : 1);
+        if (!decoded)
+        {
+            printf("Error: Failed to allocate memory for a string literal.\n");
+            exit(1);
+        }
+        if (!decode_escapes(text, length, decoded, &length))
+        {
+            free(decoded);
+            return NULL;
+        }
+        value = intern_string(parser->strings, decoded, length);
+        free(decoded);
+    }
+
+    TRACE_DEBUG(TRACE_PARSER, "Created string literal node of %zu bytes", length);
+    get_next_token(parser);
+    return create_string_literal_node(parser->arena, value, length);
 }
 
 static ASTNode *parse_print_statement(Parser *parser) __attribute__((unused));
@@ -41,9 +105,9 @@ static ASTNode *parse_print_statement(Parser *parser)
     get_next_token(parser); // Consume PRINT token
 
     // Check if the next token is an opening parenthesis
-    if (parser->current_token->type != TOKEN_LPAREN)
+    if (parser->current_token.type != TOKEN_LPAREN)
     {
-        printf("Error: Expected '(' after PRINT.\n");
+        report("Error: Expected '(' after PRINT.\n");
         return NULL;
     }
     // Move past the opening parenthesis
@@ -58,9 +122,9 @@ static ASTNode *parse_print_statement(Parser *parser)
     }
 
     // Check if the next token is a closing parenthesis
-    if (parser->current_token->type != TOKEN_RPAREN)
+    if (parser->current_token.type != TOKEN_RPAREN)
     {
-        printf("Error: Expected ')' after expression in PRINT statement.\n");
+        report("Error: Expected ')' after expression in PRINT statement.\n");
         return NULL;
     }
 
@@ -68,9 +132,9 @@ static ASTNode *parse_print_statement(Parser *parser)
     get_next_token(parser);
 
     // Check if the statement ends with a semicolon
-    if (parser->current_token->type != TOKEN_SEMICOLON)
+    if (parser->current_token.type != TOKEN_SEMICOLON)
     {
-        printf("Error: Expected ';' after PRINT statement.\n");
+        report("Error: Expected ';' after PRINT statement.\n");
         return NULL;
     }
 
@@ -78,7 +142,7 @@ static ASTNode *parse_print_statement(Parser *parser)
     get_next_token(parser);
 
     // Create and return a new AST node for the print statement
-    return create_node(NODE_PRINT, expr, NULL, NULL);
+    return create_node(parser->arena, NODE_PRINT, expr, NULL, NULL);
 }
 
 // This function parses all the tokens and builds the AST
@@ -89,7 +153,7 @@ ASTNode *parse_tokens(Parser *parser)
     ASTNode *current = NULL;
 
     // Keep parsing statements until we reach the end of the file
-    while (parser->current_token->type != TOKEN_EOF)
+    while (parser->current_token.type != TOKEN_EOF)
     {
         // Parse a single statement
         ASTNode *node = parse_statement(parser);
@@ -108,48 +172,45 @@ ASTNode *parse_tokens(Parser *parser)
             }
             current = node;
         }
-        else if (parser->current_token->type == TOKEN_EOF)
+        else if (parser->current_token.type == TOKEN_EOF)
         {
-            // If we reach the end of the file, break out of the loop
-            break; // End of file reached
+            // The statement was cut short by the end of the file (the error was already printed)
+            parser->had_error = true;
+            break;
         }
         else
         {
             // If we couldn't parse the statement, print an error message
-            printf("ERROR: Unexpected token in statement: Type %d, Value %s\n", parser->current_token->type, parser->current_token->value);
+            parser->had_error = true;
+            report("ERROR: Unexpected token in statement: Type %d, Value %.*s\n", parser->current_token.type,
+                   (int)parser->current_token.length, token_text(parser->lexer, &parser->current_token));
         }
     }
+    // Errors found while scanning count too, since they can cut the program short
+    parser->had_error = parser->had_error || parser->lexer->had_error;
+
     // Return the root of the AST
     return root;
 }
 
 // This function creates a new parser with the given lexer
-Parser *create_parser(Lexer *lexer)
+Parser *create_parser(Lexer *lexer, Arena *arena)
 {
     Parser *parser = malloc(sizeof(Parser));        // Allocate memory for the parser
     parser->lexer = lexer;                          // Set the lexer for the parser
-    parser->current_token = get_next_token(parser); // Get the first token
+    parser->arena = arena;                          // Set the arena that will own the AST
+    parser->strings = create_intern_table(arena);   // Names and strings are interned into the same arena
+    parser->had_error = false;                      // No statement has been rejected yet
+    get_next_token(parser);                         // Get the first token
     return parser;                                  // Return the parser
 }
 
 // This function frees the memory allocated for the parser
 void free_parser(Parser *parser)
 {
-    if (parser)
-    {
-        // Free the current token if it exists
-        if (parser->current_token)
-        {
-            if (parser->current_token->value)
-            {
-                free(parser->current_token->value);
-            }
-            free(parser->current_token);
-        }
-
-        // Free the parser itself
-        free(parser);
-    }
+    // The current token is a value inside the parser; the interned strings stay in the arena
+    free_intern_table(parser->strings);
+    free(parser);
 }
 
 // This function parses a single statement from the source code
@@ -158,11 +219,12 @@ static ASTNode *parse_statement(Parser *parser)
     ASTNode *statement = NULL;
 
     // Check the type of the current token and parse accordingly
-    switch (parser->current_token->type)
+    switch (parser->current_token.type)
     {
     case TOKEN_INT_TYPE:
     case TOKEN_FLOAT_TYPE:
     case TOKEN_STRING_TYPE:
+    case TOKEN_BOOL_TYPE:
         statement = parse_var_declaration(parser); // Parse a variable declaration
         break;
     case TOKEN_PRINT:
@@ -174,17 +236,17 @@ static ASTNode *parse_statement(Parser *parser)
     case TOKEN_EOF:
         return NULL; // End of file reached
     default:
-        printf("Unexpected token in statement: Type %d, Value %s\n", parser->current_token->type, parser->current_token->value);
+        report("Unexpected token in statement: Type %d, Value %.*s\n", parser->current_token.type,
+                   (int)parser->current_token.length, token_text(parser->lexer, &parser->current_token));
         get_next_token(parser); // Skip the unexpected token
         return NULL;
     }
 
     // Check if the statement ends with a semicolon
-    if (statement && parser->current_token->type != TOKEN_SEMICOLON)
+    if (statement && parser->current_token.type != TOKEN_SEMICOLON)
     {
-        printf("Error: Expected semicolon at the end of the statement.\n");
-        free_ast(statement); // Free the statement if it exists
-        return NULL;
+        report("Error: Expected semicolon at the end of the statement.\n");
+        return NULL; // The statement's nodes stay in the arena until it is freed
     }
 
     // If we successfully parsed a statement, move past the semicolon
@@ -199,34 +261,31 @@ static ASTNode *parse_statement(Parser *parser)
 // This function parses a variable declaration statement
 static ASTNode *parse_var_declaration(Parser *parser)
 {
-    char *type = strdup(parser->current_token->value); // Duplicate the type
+    const char *type = token_string(parser); // Interned, so it can be compared by pointer
     get_next_token(parser);
 
     // Check if the next token is an identifier
-    if (parser->current_token->type != TOKEN_IDENTIFIER)
+    if (parser->current_token.type != TOKEN_IDENTIFIER)
     {
-        printf("Error: Expected identifier after type in variable declaration.\n");
-        free(type);
+        report("Error: Expected identifier after type in variable declaration.\n");
         return NULL;
     }
 
-    char *var_name = strdup(parser->current_token->value); // Duplicate the variable name
+    const char *var_name = token_string(parser);
     get_next_token(parser);
 
     ASTNode *value = NULL; // Initialize the value to NULL
-    if (parser->current_token->type == TOKEN_ASSIGN)
+    if (parser->current_token.type == TOKEN_ASSIGN)
     { 
         get_next_token(parser); // Consume the '=' token
 
         // Check if the type is string and the value is a string
-        if (strcmp(type, "string") == 0 && parser->current_token->type == TOKEN_STRING)
+        if (type == INTERN_TYPE_STRING && parser->current_token.type == TOKEN_STRING)
         {
-            // Create a new AST node for the string literal
-            value = create_node(NODE_STRING_LITERAL, NULL, NULL, parser->current_token->value);
-            get_next_token(parser); // Move to the next token
-        } else if (strcmp(type, "bool") == 0 && parser->current_token->type == TOKEN_BOOL)
+            value = parse_string_literal(parser);
+        } else if (type == INTERN_TYPE_BOOL && parser->current_token.type == TOKEN_BOOL)
         {
-            value = create_node(NODE_BOOL_LITERAL, NULL, NULL, parser->current_token->value);
+            value = create_bool_literal_node(parser->arena, parser->current_token.bool_value);
             get_next_token(parser);
         }
         else
@@ -234,26 +293,24 @@ static ASTNode *parse_var_declaration(Parser *parser)
             value = parse_expression(parser); // Parse the expression for non-string types
         }
 
-        // If parsing the value fails, free the allocated memory and return NULL
+        // If parsing the value fails, return NULL (the arena reclaims anything already built)
         if (!value)
         {
-            free(type);     // Free the type
-            free(var_name); // Free the variable name
-            return NULL;    // Return NULL to indicate failure
+            return NULL;
         }
     }
 
     // Create and return a new AST node for the variable declaration
-    return create_var_declaration_node(type, var_name, value);
+    return create_var_declaration_node(parser->arena, type, var_name, value);
 }
 
 ASTNode *parse_print(Parser *parser)
 {
     get_next_token(parser); // Consume 'print' token
 
-    if (parser->current_token->type != TOKEN_LPAREN)
+    if (parser->current_token.type != TOKEN_LPAREN)
     {
-        printf("Error: Expected '(' after print.\n");
+        report("Error: Expected '(' after print.\n");
         return NULL;
     }
     get_next_token(parser);
@@ -264,35 +321,32 @@ ASTNode *parse_print(Parser *parser)
         return NULL;
     }
 
-    if (parser->current_token->type != TOKEN_RPAREN)
+    if (parser->current_token.type != TOKEN_RPAREN)
     {
-        printf("Error: Expected ')' after print argument.\n");
-        free_ast(expression);
+        report("Error: Expected ')' after print argument.\n");
         return NULL;
     }
     get_next_token(parser);
 
-    return create_node(NODE_PRINT, expression, NULL, NULL);
+    return create_node(parser->arena, NODE_PRINT, expression, NULL, NULL);
 }
 
 static ASTNode *parse_assignment(Parser *parser)
 {
-    char *var_name = strdup(parser->current_token->value);
+    const char *var_name = token_string(parser);
     get_next_token(parser);
 
-    if (parser->current_token->type != TOKEN_ASSIGN)
+    if (parser->current_token.type != TOKEN_ASSIGN)
     {
-        printf("Error: Expected '=' in assignment.\n");
-        free(var_name);
+        report("Error: Expected '=' in assignment.\n");
         return NULL;
     }
     get_next_token(parser);
 
-    ASTNode *value = parse_expression(parser);
-
-    if (parser->current_token->type == TOKEN_BOOL)
+    ASTNode *value;
+    if (parser->current_token.type == TOKEN_BOOL)
     {
-        value = create_node(NODE_BOOL_LITERAL, NULL, NULL, parser->current_token->value);
+        value = create_bool_literal_node(parser->arena, parser->current_token.bool_value);
         get_next_token(parser);
     } else {
         value = parse_expression(parser);
@@ -300,25 +354,60 @@ static ASTNode *parse_assignment(Parser *parser)
 
     if (!value)
     {
-        free(var_name);
         return NULL;
     }
 
-    return create_assignment_node(var_name, value);
+    return create_assignment_node(parser->arena, var_name, value);
+}
+
+// This function maps an operator token onto the AST's operator enum
+static bool binary_operator(TokenType type, BinaryOperator *op)
+{
+    switch (type)
+    {
+    case TOKEN_PLUS:
+        *op = BINOP_ADD;
+        return true;
+    case TOKEN_MINUS:
+        *op = BINOP_SUB;
+        return true;
+    case TOKEN_MULTIPLY:
+        *op = BINOP_MUL;
+        return true;
+    case TOKEN_DIVIDE:
+        *op = BINOP_DIV;
+        return true;
+    case TOKEN_MODULUS:
+        *op = BINOP_MOD;
+        return true;
+    case TOKEN_POWER:
+        *op = BINOP_POW;
+        return true;
+    default:
+        return false;
+    }
 }
 
 static ASTNode *parse_expression(Parser *parser)
 {
     ASTNode *left = parse_term(parser);
+    if (!left)
+    {
+        return NULL;
+    }
+    BinaryOperator op;
 
-    while (parser->current_token->type == TOKEN_PLUS || parser->current_token->type == TOKEN_MINUS)
+    while ((parser->current_token.type == TOKEN_PLUS || parser->current_token.type == TOKEN_MINUS) &&
+           binary_operator(parser->current_token.type, &op))
     {
-        Token *op_token = parser->current_token;
-        char *op = op_token->type == TOKEN_PLUS ? "+" : "-";
         get_next_token(parser);
         ASTNode *right = parse_term(parser);
-        left = create_node(NODE_BINARY_OP, left, right, op);
-        printf("Debug: Created binary op node: %s\n", op);
+        if (!right)
+        {
+            return NULL; // The operand's error has already been reported
+        }
+        left = create_binary_op_node(parser->arena, op, left, right);
+        TRACE_DEBUG(TRACE_PARSER, "Created binary op node: %s", binary_operator_name(op));
     }
 
     return left;
@@ -327,13 +416,21 @@ static ASTNode *parse_expression(Parser *parser)
 static ASTNode *parse_power(Parser *parser)
 {
     ASTNode *left = parse_factor(parser);
+    if (!left)
+    {
+        return NULL;
+    }
 
-    while (parser->current_token->type == TOKEN_POWER)
+    while (parser->current_token.type == TOKEN_POWER)
     {
         get_next_token(parser);
         ASTNode *right = parse_factor(parser);
-        left = create_node(NODE_BINARY_OP, left, right, "**");
-        printf("Debug: Created binary op node: **\n");
+        if (!right)
+        {
+            return NULL; // The operand's error has already been reported
+        }
+        left = create_binary_op_node(parser->arena, BINOP_POW, left, right);
+        TRACE_DEBUG(TRACE_PARSER, "Created binary op node: **");
     }
 
     return left;
@@ -342,21 +439,25 @@ static ASTNode *parse_power(Parser *parser)
 static ASTNode *parse_term(Parser *parser)
 {
     ASTNode *left = parse_power(parser);
+    if (!left)
+    {
+        return NULL;
+    }
+    BinaryOperator op;
 
-    while (parser->current_token->type == TOKEN_MULTIPLY || 
-           parser->current_token->type == TOKEN_DIVIDE ||
-           parser->current_token->type == TOKEN_MODULUS)
+    while ((parser->current_token.type == TOKEN_MULTIPLY || 
+            parser->current_token.type == TOKEN_DIVIDE ||
+            parser->current_token.type == TOKEN_MODULUS) &&
+           binary_operator(parser->current_token.type, &op))
     {
-        Token *op_token = parser->current_token;
-        char *op;
-        if (op_token->type == TOKEN_MULTIPLY) op = "*";
-        else if (op_token->type == TOKEN_DIVIDE) op = "/";
-        else op = "%";
-        
         get_next_token(parser);
         ASTNode *right = parse_power(parser);
-        left = create_node(NODE_BINARY_OP, left, right, op);
-        printf("Debug: Created binary op node: %s\n", op);
+        if (!right)
+        {
+            return NULL; // The operand's error has already been reported
+        }
+        left = create_binary_op_node(parser->arena, op, left, right);
+        TRACE_DEBUG(TRACE_PARSER, "Created binary op node: %s", binary_operator_name(op));
     }
 
     return left;
@@ -364,48 +465,59 @@ static ASTNode *parse_term(Parser *parser)
 
 static ASTNode *parse_factor(Parser *parser)
 {
-    Token *token = parser->current_token;
+    Token *token = &parser->current_token;
 
     if (token->type == TOKEN_NUMBER)
     {
-        ASTNode *node = create_node(NODE_INT_LITERAL, NULL, NULL, token->value);
-        printf("Debug: Created int literal node: %s\n", token->value);
+        // The lexer has already decoded the number, so only the value is kept
+        ASTNode *node = create_int_literal_node(parser->arena, token->int_value);
+        TRACE_DEBUG(TRACE_PARSER, "Created int literal node: %d", token->int_value);
+        get_next_token(parser);
+        return node;
+    }
+    else if (token->type == TOKEN_FLOAT)
+    {
+        ASTNode *node = create_float_literal_node(parser->arena, token->float_value);
+        TRACE_DEBUG(TRACE_PARSER, "Created float literal node: %g", token->float_value);
         get_next_token(parser);
         return node;
     }
     else if (token->type == TOKEN_IDENTIFIER)
     {
-        ASTNode *node = create_node(NODE_LITERAL, NULL, NULL, token->value);
-        printf("Debug: Created identifier node: %s\n", token->value);
+        const char *text = token_string(parser);
+        ASTNode *node = create_node(parser->arena, NODE_LITERAL, NULL, NULL, text);
+        TRACE_DEBUG(TRACE_PARSER, "Created identifier node: %s", text);
         get_next_token(parser);
         return node;
     } else if (token->type == TOKEN_BOOL)
     {
-        ASTNode *node = create_node(NODE_BOOL_LITERAL, NULL, NULL, token->value);
-        printf("Debug: Created bool literal node: %s\n", token->value);
+        ASTNode *node = create_bool_literal_node(parser->arena, token->bool_value);
+        TRACE_DEBUG(TRACE_PARSER, "Created bool literal node: %s", token->bool_value ? "true" : "false");
         get_next_token(parser);
         return node;
     }
     else if (token->type == TOKEN_STRING)
     {
-        ASTNode *node = create_node(NODE_STRING_LITERAL, NULL, NULL, token->value);
-        printf("Debug: Created string literal node: %s\n", token->value);
-        get_next_token(parser);
-        return node;
+        return parse_string_literal(parser);
+    }
+    else if (token->type == TOKEN_UNKNOWN)
+    {
+        get_next_token(parser); // The lexer has already reported it
+        return NULL;
     }
     else if (token->type == TOKEN_LPAREN)
     {
         get_next_token(parser);
         ASTNode *expr = parse_expression(parser);
-        if (parser->current_token->type != TOKEN_RPAREN)
+        if (parser->current_token.type != TOKEN_RPAREN)
         {
-            printf("Error: Expected closing parenthesis\n");
+            report("Error: Expected closing parenthesis\n");
             return NULL;
         }
         get_next_token(parser);
         return expr;
     }
 
-    printf("Error: Unexpected token in factor\n");
+    report("Error: Unexpected token in factor\n");
     return NULL;
 }
@@ -4,19 +4,24 @@
 
 #include "lexer/lexer.h"
 #include "ast/ast.h"
+#include "common/intern.h"
 
 typedef struct {
     Lexer *lexer;
-    Token *current_token;
+    Token current_token;
+    Arena *arena;         // Owns every node of the AST being built
+    InternTable *strings; // Every name, type name and string literal in the AST, stored once
+    bool had_error;       // Set if any statement or token was rejected (the AST holds the rest)
 } Parser;
 
 /**
  * @brief Creates a new parser with the given lexer.
  * 
  * @param lexer A pointer to the Lexer structure.
+ * @param arena The arena that will own the generated AST.
  * @return Parser* A pointer to the newly created Parser structure.
  */
-Parser *create_parser(Lexer *lexer);
+Parser *create_parser(Lexer *lexer, Arena *arena);
 
 /**
  * @brief Frees the memory allocated for the parser.
@@ -28,8 +33,11 @@ void free_parser(Parser *parser);
 /**
  * @brief Parses the tokens and generates an Abstract Syntax Tree (AST).
  * 
+ * Statements with syntax errors are reported and left out, and parsing
+ * continues with the next statement; parser->had_error tells whether any were.
+ *
  * @param parser A pointer to the Parser structure.
- * @return ASTNode* The root node of the generated AST.
+ * @return ASTNode* The root node of the generated AST, owned by the parser's arena.
  */
 ASTNode *parse_tokens(Parser *parser);
 
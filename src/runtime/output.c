@@ -0,0 +1,186 @@
+#include "output.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+#define MEMORY_OUTPUT_INITIAL_SIZE 4096 // Most programs print little, and memory writers grow
+
+// "00" "01" ... "99": lets integers be formatted two digits at a time
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// This function creates a writer for 'fd'
+Output *create_output(int fd)
+{
+    Output *out = (Output *)malloc(sizeof(Output));
+    char *buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+    if (!out || !buffer)
+    {
+        printf("Error: Failed to allocate memory for the output buffer.\n");
+        exit(1);
+    }
+
+    out->buffer = buffer;
+    out->length = 0;
+    out->capacity = OUTPUT_BUFFER_SIZE;
+    out->fd = fd;
+    out->line_buffered = isatty(fd); // Someone is watching: show each line as soon as it is complete
+    out->failed = false;
+    return out;
+}
+
+// This function creates a writer that keeps everything in memory
+Output *create_memory_output(void)
+{
+    Output *out = (Output *)malloc(sizeof(Output));
+    char *buffer = (char *)malloc(MEMORY_OUTPUT_INITIAL_SIZE);
+    if (!out || !buffer)
+    {
+        printf("Error: Failed to allocate memory for the output buffer.\n");
+        exit(1);
+    }
+
+    out->buffer = buffer;
+    out->length = 0;
+    out->capacity = MEMORY_OUTPUT_INITIAL_SIZE;
+    out->fd = OUTPUT_MEMORY;
+    out->line_buffered = false;
+    out->failed = false;
+    return out;
+}
+
+// This function writes all of data[0, length) to the file descriptor, retrying short writes
+static bool write_fully(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// This function empties the buffer into the file descriptor; memory writers keep their bytes
+bool output_flush(Output *out)
+{
+    if (out->fd == OUTPUT_MEMORY)
+    {
+        return !out->failed;
+    }
+    if (out->length > 0 && !out->failed)
+    {
+        out->failed = !write_fully(out->fd, out->buffer, out->length);
+    }
+    out->length = 0;
+    return !out->failed;
+}
+
+// This function handles writes that do not fit in the space left in the buffer
+void output_write_slow(Output *out, const char *data, size_t length)
+{
+    // Memory writers grow instead, doubling so appends stay linear overall
+    if (out->fd == OUTPUT_MEMORY)
+    {
+        if (out->failed)
+        {
+            return;
+        }
+        size_t capacity = out->capacity;
+        while (capacity - out->length < length)
+        {
+            capacity *= 2;
+        }
+        char *buffer = (char *)realloc(out->buffer, capacity);
+        if (!buffer)
+        {
+            out->failed = true;
+            return;
+        }
+        out->buffer = buffer;
+        out->capacity = capacity;
+        memcpy(out->buffer + out->length, data, length);
+        out->length += length;
+        return;
+    }
+
+    output_flush(out);
+
+    // Data at least as big as the buffer goes straight to the file descriptor
+    if (length >= out->capacity)
+    {
+        if (!out->failed)
+        {
+            out->failed = !write_fully(out->fd, data, length);
+        }
+        return;
+    }
+
+    memcpy(out->buffer, data, length);
+    out->length = length;
+}
+
+// This function formats an integer without going through printf
+void output_int(Output *out, int value)
+{
+    char digits[16];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+
+    // Work in unsigned so INT_MIN can be negated safely
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    while (magnitude >= 100)
+    {
+        unsigned int pair = (magnitude % 100) * 2;
+        magnitude /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (magnitude >= 10)
+    {
+        unsigned int pair = magnitude * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    else
+    {
+        *--p = (char)('0' + magnitude);
+    }
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+
+    output_write(out, p, (size_t)(end - p));
+}
+
+// This function flushes and frees the writer
+void free_output(Output *out)
+{
+    if (out)
+    {
+        output_flush(out);
+        free(out->buffer);
+        free(out);
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// A buffered writer for program output.
+// Everything the running program prints goes through one of these instead of
+// stdio, so printing a value is a memcpy into a large user-space buffer and a
+// write() happens only when the buffer fills up, on an explicit flush, or at
+// the end of each line when line buffering is on.
+//
+// A memory writer (see create_memory_output()) never writes anywhere: it
+// grows as needed and keeps everything in buffer[0, length) until the owner
+// takes it, for example to emit several programs' output in a fixed order.
+typedef struct
+{
+    char *buffer;
+    size_t length;       // Bytes currently buffered
+    size_t capacity;     // Size of 'buffer'
+    int fd;              // Destination file descriptor, or OUTPUT_MEMORY
+    bool line_buffered;  // Flush after every newline (interactive terminals)
+    bool failed;         // A write error occurred; further output is discarded
+} Output;
+
+// The 'fd' of a writer that keeps its output in memory
+#define OUTPUT_MEMORY (-1)
+
+/**
+ * @brief Creates a buffered writer for a file descriptor.
+ *
+ * Line buffering is turned on automatically when 'fd' is a terminal.
+ *
+ * @param fd The file descriptor to write to.
+ * @return Output* A pointer to the newly created Output.
+ */
+Output *create_output(int fd);
+
+/**
+ * @brief Creates a writer that keeps all output in memory.
+ *
+ * The output is in out->buffer[0, out->length); set out->length to 0 to
+ * reuse the writer. Flushing does nothing.
+ *
+ * @return Output* A pointer to the newly created Output.
+ */
+Output *create_memory_output(void);
+
+/**
+ * @brief Writes everything buffered so far to the file descriptor.
+ *
+ * @param out A pointer to the Output.
+ * @return bool true on success, false if the write failed.
+ */
+bool output_flush(Output *out);
+
+/**
+ * @brief Flushes and frees a writer.
+ *
+ * @param out A pointer to the Output to be freed.
+ */
+void free_output(Output *out);
+
+/**
+ * @brief Writes bytes that do not fit in the remaining buffer space. Use output_write().
+ */
+void output_write_slow(Output *out, const char *data, size_t length);
+
+/**
+ * @brief Writes a signed integer in decimal.
+ *
+ * @param out A pointer to the Output.
+ * @param value The value to write.
+ */
+void output_int(Output *out, int value);
+
+/**
+ * @brief Writes 'length' bytes.
+ *
+ * @param out A pointer to the Output.
+ * @param data The bytes to write (need not be NUL-terminated).
+ * @param length The number of bytes.
+ */
+static inline void output_write(Output *out, const char *data, size_t length)
+{
+    if (out->capacity - out->length >= length)
+    {
+        memcpy(out->buffer + out->length, data, length);
+        out->length += length;
+        return;
+    }
+    output_write_slow(out, data, length);
+}
+
+/**
+ * @brief Ends the current line, flushing it if the writer is line buffered.
+ *
+ * @param out A pointer to the Output.
+ */
+static inline void output_newline(Output *out)
+{
+    if (out->length == out->capacity)
+    {
+        output_write_slow(out, "\n", 1);
+    }
+    else
+    {
+        out->buffer[out->length++] = '\n';
+    }
+    if (out->line_buffered)
+    {
+        output_flush(out);
+    }
+}
+
+/**
+ * @brief Writes a boolean as "true" or "false".
+ *
+ * @param out A pointer to the Output.
+ * @param value The value to write.
+ */
+static inline void output_bool(Output *out, bool value)
+{
+    if (value)
+        output_write(out, "true", 4);
+    else
+        output_write(out, "false", 5);
+}
+
+/**
+ * @brief Writes a NUL-terminated string.
+ *
+ * @param out A pointer to the Output.
+ * @param str The string to write.
+ */
+static inline void output_string(Output *out, const char *str)
+{
+    output_write(out, str, strlen(str));
+}
+
+#endif // OUTPUT_H
@@ -0,0 +1,169 @@
+#include "resolver.h"
+#include "common/report.h"
+#include "common/trace.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Names are interned, so the hash is computed from the pointer rather than the characters
+static uint32_t hash_name(const char *name)
+{
+    return (uint32_t)(((uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// This function finds the bucket that holds 'name', or the empty bucket where it belongs
+static SymbolEntry *find_entry(SymbolEntry *entries, size_t capacity, const char *name)
+{
+    size_t mask = capacity - 1;
+    size_t index = hash_name(name) & mask;
+    while (entries[index].name != NULL && entries[index].name != name)
+    {
+        index = (index + 1) & mask;
+    }
+    return &entries[index];
+}
+
+// This function doubles the hash table and re-inserts every binding
+static void grow_entries(SymbolTable *symbols)
+{
+    size_t capacity = symbols->entry_capacity ? symbols->entry_capacity * 2 : 64;
+    SymbolEntry *entries = (SymbolEntry *)calloc(capacity, sizeof(SymbolEntry));
+    if (!entries)
+    {
+        printf("Error: Failed to allocate memory for the symbol table.\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < symbols->entry_capacity; i++)
+    {
+        if (symbols->entries[i].name != NULL)
+        {
+            *find_entry(entries, capacity, symbols->entries[i].name) = symbols->entries[i];
+        }
+    }
+
+    free(symbols->entries);
+    symbols->entries = entries;
+    symbols->entry_capacity = capacity;
+}
+
+// This function creates an empty symbol table
+SymbolTable *create_symbol_table(void)
+{
+    SymbolTable *symbols = (SymbolTable *)calloc(1, sizeof(SymbolTable));
+    if (!symbols)
+    {
+        printf("Error: Failed to allocate memory for the symbol table.\n");
+        exit(1);
+    }
+    grow_entries(symbols);
+    return symbols;
+}
+
+// This function allocates a new slot for a declaration and makes 'name' refer to it
+static int declare(SymbolTable *symbols, const char *name)
+{
+    if (symbols->slot_count == symbols->slot_capacity)
+    {
+        symbols->slot_capacity = symbols->slot_capacity ? symbols->slot_capacity * 2 : 64;
+        symbols->slot_names = realloc(symbols->slot_names, symbols->slot_capacity * sizeof(const char *));
+        if (!symbols->slot_names)
+        {
+            printf("Error: Failed to allocate memory for the symbol table.\n");
+            exit(1);
+        }
+    }
+
+    int slot = (int)symbols->slot_count++;
+    symbols->slot_names[slot] = name;
+
+    // Keep the load factor under 3/4 so probe sequences stay short
+    if ((symbols->entry_count + 1) * 4 > symbols->entry_capacity * 3)
+    {
+        grow_entries(symbols);
+    }
+
+    SymbolEntry *entry = find_entry(symbols->entries, symbols->entry_capacity, name);
+    if (entry->name == NULL)
+    {
+        entry->name = name;
+        symbols->entry_count++;
+    }
+    entry->slot = slot;
+    TRACE_DEBUG(TRACE_RESOLVER, "Declared %s in slot %d", name, slot);
+    return slot;
+}
+
+// This function returns the slot 'name' currently refers to, or -1 if it is undeclared
+static int lookup(SymbolTable *symbols, const char *name)
+{
+    SymbolEntry *entry = find_entry(symbols->entries, symbols->entry_capacity, name);
+    return entry->name != NULL ? entry->slot : -1;
+}
+
+// This function resolves every identifier inside an expression
+static bool resolve_expression(SymbolTable *symbols, ASTNode *node)
+{
+    if (node == NULL)
+    {
+        return true;
+    }
+
+    if (node->type == NODE_LITERAL)
+    {
+        node->slot = lookup(symbols, node->value);
+        if (node->slot < 0)
+        {
+            report("Error: Undefined variable '%s'.\n", node->value);
+            return false;
+        }
+        return true;
+    }
+
+    bool left_ok = resolve_expression(symbols, node->left);
+    bool right_ok = resolve_expression(symbols, node->right);
+    return left_ok && right_ok;
+}
+
+// This function resolves the statement list in program order
+bool resolve_program(SymbolTable *symbols, ASTNode *node)
+{
+    bool ok = true;
+
+    for (; node != NULL; node = node->next)
+    {
+        switch (node->type)
+        {
+        case NODE_VAR_DECLARATION:
+            // The initializer is resolved first, so 'int x = x;' refers to an earlier x
+            ok &= resolve_expression(symbols, node->left);
+            node->slot = declare(symbols, node->var_name);
+            break;
+        case NODE_ASSIGNMENT:
+            ok &= resolve_expression(symbols, node->left);
+            node->slot = lookup(symbols, node->var_name);
+            if (node->slot < 0)
+            {
+                report("Error: Undefined variable %s\n", node->var_name);
+                ok = false;
+            }
+            break;
+        default:
+            ok &= resolve_expression(symbols, node->left);
+            break;
+        }
+    }
+
+    return ok;
+}
+
+// This function frees the symbol table
+void free_symbol_table(SymbolTable *symbols)
+{
+    if (symbols)
+    {
+        free(symbols->entries);
+        free(symbols->slot_names);
+        free(symbols);
+    }
+}
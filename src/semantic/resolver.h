@@ -0,0 +1,58 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "ast/ast.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// One entry of the name -> slot hash table
+typedef struct
+{
+    const char *name; // NULL marks an empty bucket
+    int slot;
+} SymbolEntry;
+
+// Maps variable names to the numeric slots the execution engines index directly
+typedef struct
+{
+    SymbolEntry *entries;   // Open-addressed table holding the current binding of each name
+    size_t entry_capacity;  // Always a power of two
+    size_t entry_count;
+
+    const char **slot_names; // Name declared in each slot, for diagnostics
+    size_t slot_count;
+    size_t slot_capacity;
+} SymbolTable;
+
+/**
+ * @brief Creates an empty symbol table.
+ *
+ * @return SymbolTable* A pointer to the newly created SymbolTable.
+ */
+SymbolTable *create_symbol_table(void);
+
+/**
+ * @brief Binds every variable reference in the program to a slot index.
+ *
+ * Names are compared by pointer, so they must be interned (as the parser
+ * does). Each declaration gets a fresh slot; identifiers, assignments and
+ * declarations then store that slot in their node's `slot` field so the
+ * execution engines never look variables up by name. A redeclaration
+ * shadows the earlier variable from that point on.
+ *
+ * @param symbols The table that receives the bindings.
+ * @param node The root node of the AST (the first statement in the list).
+ * @return bool true on success, false if an undefined variable was referenced.
+ */
+bool resolve_program(SymbolTable *symbols, ASTNode *node);
+
+/**
+ * @brief Frees the memory allocated for a symbol table.
+ *
+ * The names themselves belong to the AST and are not freed.
+ *
+ * @param symbols A pointer to the SymbolTable to be freed.
+ */
+void free_symbol_table(SymbolTable *symbols);
+
+#endif // RESOLVER_H
@@ -0,0 +1,169 @@
+#include "typecheck.h"
+#include "common/intern.h"
+#include "common/report.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// State carried through one type check
+typedef struct
+{
+    VariableType *slot_types; // Declared type of each variable slot seen so far
+    bool had_error;
+} TypeChecker;
+
+static const char *type_name(VariableType type)
+{
+    switch (type)
+    {
+    case INT_TYPE:
+        return "int";
+    case FLOAT_TYPE:
+        return "float";
+    case STRING_TYPE:
+        return "string";
+    case BOOL_TYPE:
+        return "bool";
+    }
+    return "unknown";
+}
+
+// This function picks the indefinite article for a type name ("an int", "a string")
+static const char *article(const char *name)
+{
+    return name[0] == 'a' || name[0] == 'e' || name[0] == 'i' || name[0] == 'o' || name[0] == 'u' ? "an" : "a";
+}
+
+// This function maps a declaration's type name onto a VariableType
+static VariableType declared_type(const char *name)
+{
+    if (name == INTERN_TYPE_INT)
+        return INT_TYPE;
+    if (name == INTERN_TYPE_STRING)
+        return STRING_TYPE;
+    if (name == INTERN_TYPE_BOOL)
+        return BOOL_TYPE;
+    return FLOAT_TYPE;
+}
+
+// This function works out the type of an expression, stores it in the node and reports operand type errors
+static VariableType check_expression(TypeChecker *checker, ASTNode *node)
+{
+    switch (node->type)
+    {
+    case NODE_INT_LITERAL:
+        node->value_type = INT_TYPE;
+        break;
+    case NODE_BOOL_LITERAL:
+        node->value_type = BOOL_TYPE;
+        break;
+    case NODE_STRING_LITERAL:
+        node->value_type = STRING_TYPE;
+        break;
+    case NODE_LITERAL:
+        node->value_type = checker->slot_types[node->slot];
+        break;
+    case NODE_FLOAT_LITERAL:
+        report("Error: Float values are not supported yet.\n");
+        checker->had_error = true;
+        node->value_type = FLOAT_TYPE;
+        break;
+    case NODE_BINARY_OP:
+    {
+        // Every operator takes and produces integers
+        VariableType left = check_expression(checker, node->left);
+        VariableType right = check_expression(checker, node->right);
+        if (left != INT_TYPE || right != INT_TYPE)
+        {
+            report("Error: Operands of '%s' must be integers.\n", binary_operator_name(node->op));
+            checker->had_error = true;
+        }
+        node->value_type = INT_TYPE;
+        break;
+    }
+    default:
+        report("Error: Unsupported expression node type %d.\n", node->type);
+        checker->had_error = true;
+        node->value_type = INT_TYPE;
+        break;
+    }
+    return node->value_type;
+}
+
+// This function checks a declaration and records the type of its slot
+static void check_var_declaration(TypeChecker *checker, ASTNode *node)
+{
+    VariableType type = declared_type(node->var_type);
+    node->value_type = type;
+    checker->slot_types[node->slot] = type;
+
+    // 'float' is a keyword, but float variables are not supported yet
+    if (type == FLOAT_TYPE)
+    {
+        report("Error: Unsupported variable type '%s'.\n", node->var_type);
+        checker->had_error = true;
+        return;
+    }
+
+    if (node->left)
+    {
+        VariableType value_type = check_expression(checker, node->left);
+        if (value_type != type)
+        {
+            report("Error: Cannot initialize %s variable '%s' with %s %s value.\n",
+                   type_name(type), node->var_name, article(type_name(value_type)), type_name(value_type));
+            checker->had_error = true;
+        }
+    }
+}
+
+// This function checks that an assignment stores a value of the variable's type
+static void check_assignment(TypeChecker *checker, ASTNode *node)
+{
+    VariableType var_type = checker->slot_types[node->slot];
+    node->value_type = var_type;
+
+    VariableType value_type = check_expression(checker, node->left);
+    if (value_type != var_type)
+    {
+        report("Error: Cannot assign %s %s value to %s variable '%s'.\n",
+               article(type_name(value_type)), type_name(value_type), type_name(var_type), node->var_name);
+        checker->had_error = true;
+    }
+}
+
+// This function checks every statement in program order, so each use sees the declaration in effect
+bool typecheck_program(ASTNode *node, size_t slot_count)
+{
+    TypeChecker checker;
+    checker.had_error = false;
+    checker.slot_types = (VariableType *)calloc(slot_count ? slot_count : 1, sizeof(VariableType));
+    if (!checker.slot_types)
+    {
+        printf("Error: Failed to allocate memory for variables.\n");
+        exit(1);
+    }
+
+    for (; node != NULL; node = node->next)
+    {
+        switch (node->type)
+        {
+        case NODE_VAR_DECLARATION:
+            check_var_declaration(&checker, node);
+            break;
+        case NODE_ASSIGNMENT:
+            check_assignment(&checker, node);
+            break;
+        case NODE_PRINT:
+            // A print statement has the type of the value it prints
+            node->value_type = check_expression(&checker, node->left);
+            break;
+        default:
+            report("Error: Unknown node type in type checker: %d\n", node->type);
+            checker.had_error = true;
+            break;
+        }
+    }
+
+    free(checker.slot_types);
+    return !checker.had_error;
+}
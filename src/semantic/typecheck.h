@@ -0,0 +1,25 @@
+#ifndef TYPECHECK_H
+#define TYPECHECK_H
+
+#include "ast/ast.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Checks the types of a resolved program and annotates its nodes.
+ *
+ * Runs after the resolver and before the optimizer. Every expression node's
+ * `value_type` is set to the type of the value it produces, every
+ * declaration's and assignment's to the type of its variable, and every
+ * print statement's to the type of the value it prints.
+ * The execution engines rely on these annotations to pick type-specific code
+ * paths, so they never check types at run time. All type errors are reported
+ * before returning, and nothing should be executed if any were found.
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param slot_count The number of variable slots assigned by the resolver.
+ * @return bool true if the program is well typed, false otherwise.
+ */
+bool typecheck_program(ASTNode *node, size_t slot_count);
+
+#endif // TYPECHECK_H
@@ -0,0 +1,90 @@
+#include "server.h"
+#include "protocol.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// This function turns a script path into the absolute path the server looks up,
+// resolving symbolic links so every spelling of a file shares one cache entry
+static bool absolute_path(const char *path, char *resolved)
+{
+    if (realpath(path, resolved) != NULL)
+    {
+        return true;
+    }
+    // A missing file is still sent, so the server reports it like a cold run would
+    if (path[0] == '/')
+    {
+        return strlen(path) < PATH_MAX && strcpy(resolved, path) != NULL;
+    }
+    char cwd[PATH_MAX];
+    return getcwd(cwd, sizeof(cwd)) != NULL && snprintf(resolved, PATH_MAX, "%s/%s", cwd, path) < PATH_MAX;
+}
+
+// This function sends one run request and reads the whole reply
+bool request_run(const char *socket_path, const char *script_path, ExecutionEngine engine, int opt_level,
+                 ServerReply *reply)
+{
+    if (strcmp(script_path, "-") == 0)
+    {
+        printf("Error: A server cannot read the program from stdin.\n");
+        return false;
+    }
+    char path[PATH_MAX];
+    if (!absolute_path(script_path, path) || strlen(path) > PROTOCOL_MAX_PATH)
+    {
+        printf("Error: Could not resolve the path '%s'.\n", script_path);
+        return false;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        printf("Error: Socket path '%s' is too long.\n", socket_path);
+        return false;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        printf("Error: Could not connect to a server on '%s' (start one with --serve).\n", socket_path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    ServerRequest request = {PROTOCOL_MAGIC, (uint8_t)engine, (uint8_t)opt_level, 0, (uint32_t)strlen(path)};
+    ServerResponse response;
+    bool ok = send_fully(fd, &request, sizeof(request)) && send_fully(fd, path, request.path_length) &&
+              receive_fully(fd, &response, sizeof(response)) && response.magic == PROTOCOL_MAGIC;
+
+    reply->status = ok ? response.status : 1;
+    reply->output_length = ok ? (size_t)response.output_length : 0;
+    reply->output = (char *)malloc(reply->output_length ? reply->output_length : 1);
+    if (ok && (!reply->output || !receive_fully(fd, reply->output, reply->output_length)))
+    {
+        ok = false;
+    }
+    close(fd);
+
+    if (!ok)
+    {
+        printf("Error: The server on '%s' did not answer.\n", socket_path);
+        free_server_reply(reply);
+    }
+    return ok;
+}
+
+// This function frees the output of a reply
+void free_server_reply(ServerReply *reply)
+{
+    free(reply->output);
+    reply->output = NULL;
+    reply->output_length = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// The messages exchanged by `a++c --connect` and `a++c --serve` over a Unix
+// domain socket. Both ends are the same build on the same machine, so the
+// structs are sent as they are in memory. One connection carries one request.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define PROTOCOL_MAGIC 0x2B2B4131u // "A++" and a version digit; bumped when a message changes
+#define PROTOCOL_MAX_PATH 4096
+
+// Sent by the client, followed by 'path_length' bytes of the script's absolute path
+typedef struct
+{
+    uint32_t magic;
+    uint8_t engine;    // ExecutionEngine
+    uint8_t opt_level; // OPT_LEVEL_*
+    uint16_t reserved;
+    uint32_t path_length;
+} ServerRequest;
+
+// Sent back by the server, followed by 'output_length' bytes of output
+typedef struct
+{
+    uint32_t magic;
+    int32_t status;         // The exit status the a++c driver would have returned
+    uint64_t output_length; // Everything the run printed, compile errors included
+} ServerResponse;
+
+// This function writes all of data[0, length) to the socket, retrying short writes
+static inline bool send_fully(int fd, const void *data, size_t length)
+{
+    const char *p = (const char *)data;
+    while (length > 0)
+    {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// This function reads exactly 'length' bytes from the socket
+static inline bool receive_fully(int fd, void *data, size_t length)
+{
+    char *p = (char *)data;
+    while (length > 0)
+    {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+#endif // PROTOCOL_H
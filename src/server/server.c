@@ -0,0 +1,468 @@
+#include "server.h"
+#include "protocol.h"
+#include "common/report.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// One built program kept by the server
+typedef struct ProgramEntry
+{
+    char *path;
+    int opt_level;
+    struct timespec mtime; // The file's modification time and size when it was built
+    off_t size;
+    Program *program;
+    Context *contexts[ENGINE_JIT + 1]; // Idle contexts by engine; a request takes one out while it runs
+    size_t users;                      // Requests using the entry right now
+    bool evicted;                      // Dropped from the cache; its last user frees it
+    struct ProgramEntry *bucket_next;  // The next entry in the same hash bucket
+    struct ProgramEntry *newer;        // Neighbours in least-recently-used order
+    struct ProgramEntry *older;
+} ProgramEntry;
+
+// The built programs, found by hash and dropped in least-recently-used order
+typedef struct
+{
+    ProgramEntry **buckets;
+    size_t bucket_count;
+    ProgramEntry *newest;
+    ProgramEntry *oldest;
+    size_t count;
+    size_t max_count;
+    const char *cache_dir;
+    pthread_mutex_t lock; // Guards everything here and in the entries, except the programs themselves
+} ProgramCache;
+
+// The state shared by the listening thread and the connection threads
+typedef struct
+{
+    ProgramCache cache;
+    size_t active; // Connections being handled; shutdown waits for them
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+} Server;
+
+// What each connection thread is started with
+typedef struct
+{
+    Server *server;
+    int fd;
+} Connection;
+
+// Set by SIGINT and SIGTERM; the listening loop checks it whenever accept() is interrupted
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+// This function hashes a cache key: the path and the optimization level
+static size_t hash_key(const char *path, int opt_level)
+{
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t)opt_level;
+    for (const char *p = path; *p; p++)
+    {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ull;
+    }
+    return (size_t)hash;
+}
+
+static ProgramEntry **bucket_of(ProgramCache *cache, const char *path, int opt_level)
+{
+    return &cache->buckets[hash_key(path, opt_level) & (cache->bucket_count - 1)];
+}
+
+// This function frees an entry that is out of the cache and no longer used
+static void free_entry(ProgramEntry *entry)
+{
+    for (int engine = 0; engine <= ENGINE_JIT; engine++)
+    {
+        free_context(entry->contexts[engine]);
+    }
+    free_program(entry->program);
+    free(entry->path);
+    free(entry);
+}
+
+// This function takes an entry out of the hash table and the LRU list; it is freed once unused
+static void drop_entry(ProgramCache *cache, ProgramEntry *entry)
+{
+    ProgramEntry **link = bucket_of(cache, entry->path, entry->opt_level);
+    while (*link != entry)
+    {
+        link = &(*link)->bucket_next;
+    }
+    *link = entry->bucket_next;
+
+    if (entry->newer)
+        entry->newer->older = entry->older;
+    else
+        cache->newest = entry->older;
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+
+    cache->count--;
+    entry->evicted = true;
+    if (entry->users == 0)
+    {
+        free_entry(entry);
+    }
+}
+
+// This function puts an entry at the most recently used end of the list
+static void push_newest(ProgramCache *cache, ProgramEntry *entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest)
+        cache->newest->newer = entry;
+    else
+        cache->oldest = entry;
+    cache->newest = entry;
+}
+
+// This function marks an entry as just used
+static void touch_entry(ProgramCache *cache, ProgramEntry *entry)
+{
+    if (cache->newest == entry)
+    {
+        return;
+    }
+    entry->newer->older = entry->older;
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+    push_newest(cache, entry);
+}
+
+static ProgramEntry *find_entry(ProgramCache *cache, const char *path, int opt_level)
+{
+    for (ProgramEntry *entry = *bucket_of(cache, path, opt_level); entry; entry = entry->bucket_next)
+    {
+        if (entry->opt_level == opt_level && strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static bool same_file_version(const ProgramEntry *entry, const struct stat *info)
+{
+    return entry->mtime.tv_sec == info->st_mtim.tv_sec && entry->mtime.tv_nsec == info->st_mtim.tv_nsec &&
+           entry->size == info->st_size;
+}
+
+// This function returns the cached program for a file, building it on a miss or
+// when the file has changed. Build errors are reported to the calling thread's output.
+static ProgramEntry *acquire_entry(ProgramCache *cache, const char *path, int opt_level, const struct stat *info)
+{
+    pthread_mutex_lock(&cache->lock);
+    ProgramEntry *entry = find_entry(cache, path, opt_level);
+    if (entry && !same_file_version(entry, info))
+    {
+        drop_entry(cache, entry); // Edited since it was built
+        entry = NULL;
+    }
+    if (entry)
+    {
+        touch_entry(cache, entry);
+        entry->users++;
+        pthread_mutex_unlock(&cache->lock);
+        return entry;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    // Build without holding the lock, so other scripts are served meanwhile
+    BuildOptions build = {opt_level, cache->cache_dir};
+    Program *program = load_program(path, &build);
+    if (program == NULL)
+    {
+        return NULL; // Programs with errors are not kept, so their errors are reported every time
+    }
+    ProgramEntry *built = (ProgramEntry *)calloc(1, sizeof(ProgramEntry));
+    char *path_copy = strdup(path);
+    if (!built || !path_copy)
+    {
+        report("Error: Failed to allocate memory for the program cache.\n");
+        free(built);
+        free(path_copy);
+        free_program(program);
+        return NULL;
+    }
+    built->path = path_copy;
+    built->opt_level = opt_level;
+    built->mtime = info->st_mtim;
+    built->size = info->st_size;
+    built->program = program;
+    built->users = 1;
+
+    pthread_mutex_lock(&cache->lock);
+    entry = find_entry(cache, path, opt_level);
+    if (entry && same_file_version(entry, info))
+    {
+        // Another request built the same version first; use that one
+        touch_entry(cache, entry);
+        entry->users++;
+        pthread_mutex_unlock(&cache->lock);
+        free_entry(built);
+        return entry;
+    }
+    if (entry)
+    {
+        drop_entry(cache, entry);
+    }
+    ProgramEntry **bucket = bucket_of(cache, path, opt_level);
+    built->bucket_next = *bucket;
+    *bucket = built;
+    push_newest(cache, built);
+    cache->count++;
+    while (cache->count > cache->max_count)
+    {
+        drop_entry(cache, cache->oldest);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return built;
+}
+
+// This function hands a request the entry's idle context for an engine, or a new one if it is in use
+static Context *take_context(ProgramCache *cache, ProgramEntry *entry, ExecutionEngine engine)
+{
+    pthread_mutex_lock(&cache->lock);
+    Context *context = entry->contexts[engine];
+    entry->contexts[engine] = NULL;
+    pthread_mutex_unlock(&cache->lock);
+    return context ? context : create_context(entry->program, engine);
+}
+
+// This function gives a context back to its entry after a run, and lets go of the entry
+static void release_entry(ProgramCache *cache, ProgramEntry *entry, ExecutionEngine engine, Context *context)
+{
+    pthread_mutex_lock(&cache->lock);
+    if (context && !entry->evicted && entry->contexts[engine] == NULL)
+    {
+        entry->contexts[engine] = context;
+        context = NULL;
+    }
+    bool last_user = --entry->users == 0 && entry->evicted;
+    pthread_mutex_unlock(&cache->lock);
+
+    free_context(context); // A spare, when another request already returned one
+    if (last_user)
+    {
+        free_entry(entry);
+    }
+}
+
+// This function runs one script for a request, writing everything it prints to 'out'
+static int serve_script(Server *server, const char *path, ExecutionEngine engine, int opt_level, Output *out)
+{
+    // Compile errors go to the reply too, next to the program's output
+    set_report_output(out);
+    int status = 1;
+    const char *ext = strrchr(path, '.');
+    struct stat info;
+    if (!ext || strcmp(ext, ".a++") != 0)
+    {
+        report("Error: Input file must have a .a++ extension.\n");
+    }
+    else if (stat(path, &info) != 0)
+    {
+        report("Error: Could not open file '%s'.\n", path);
+    }
+    else
+    {
+        ProgramEntry *entry = acquire_entry(&server->cache, path, opt_level, &info);
+        if (entry)
+        {
+            Context *context = take_context(&server->cache, entry, engine);
+            if (context && run_context(context, out))
+            {
+                status = 0;
+            }
+            release_entry(&server->cache, entry, engine, context);
+        }
+    }
+    set_report_output(NULL);
+    return status;
+}
+
+// This function handles one connection: read the request, run the script, send the result
+static void *handle_connection(void *argument)
+{
+    Connection *connection = (Connection *)argument;
+    Server *server = connection->server;
+    int fd = connection->fd;
+    free(connection);
+
+    ServerRequest request;
+    char path[PROTOCOL_MAX_PATH + 1];
+    if (receive_fully(fd, &request, sizeof(request)) && request.magic == PROTOCOL_MAGIC &&
+        request.path_length > 0 && request.path_length <= PROTOCOL_MAX_PATH && request.engine <= ENGINE_JIT &&
+        receive_fully(fd, path, request.path_length))
+    {
+        path[request.path_length] = '\0';
+        Output *out = create_memory_output();
+        ServerResponse response = {PROTOCOL_MAGIC, 0, 0};
+        response.status = serve_script(server, path, (ExecutionEngine)request.engine, request.opt_level, out);
+        response.output_length = out->length;
+        if (send_fully(fd, &response, sizeof(response)))
+        {
+            send_fully(fd, out->buffer, out->length);
+        }
+        free_output(out);
+    }
+    close(fd);
+
+    pthread_mutex_lock(&server->lock);
+    if (--server->active == 0)
+    {
+        pthread_cond_signal(&server->idle);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// This function binds the listening socket, replacing a stale socket file left by a server that died
+static int open_socket(const char *socket_path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        printf("Error: Socket path '%s' is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        printf("Error: Could not create a socket.\n");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+    {
+        printf("Error: A server is already listening on '%s'.\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    unlink(socket_path);
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        printf("Error: Could not listen on '%s'.\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// This function accepts connections until a stop signal, handling each on its own thread
+int run_server(const ServerOptions *options)
+{
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.cache.max_count = options->max_programs ? options->max_programs : 1;
+    server.cache.cache_dir = options->cache_dir;
+    server.cache.bucket_count = 64;
+    while (server.cache.bucket_count < server.cache.max_count * 2)
+    {
+        server.cache.bucket_count *= 2;
+    }
+    server.cache.buckets = (ProgramEntry **)calloc(server.cache.bucket_count, sizeof(ProgramEntry *));
+    if (!server.cache.buckets)
+    {
+        printf("Error: Failed to allocate memory for the program cache.\n");
+        return 1;
+    }
+    pthread_mutex_init(&server.cache.lock, NULL);
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.idle, NULL);
+
+    // A client that hangs up early must not kill the server; a stop signal interrupts accept()
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+
+    int listen_fd = open_socket(options->socket_path);
+    int status = listen_fd < 0 ? 1 : 0;
+    if (listen_fd >= 0)
+    {
+        printf("Listening on %s\n", options->socket_path);
+        fflush(stdout);
+    }
+
+    while (listen_fd >= 0 && !stop_requested)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            continue; // Interrupted by a signal, or a connection that went away first
+        }
+
+        Connection *connection = (Connection *)malloc(sizeof(Connection));
+        if (!connection)
+        {
+            close(fd);
+            continue;
+        }
+        *connection = (Connection){&server, fd};
+        pthread_mutex_lock(&server.lock);
+        server.active++;
+        pthread_mutex_unlock(&server.lock);
+
+        // Connection threads never take the stop signals, so they always reach this thread
+        sigset_t previous;
+        pthread_t thread;
+        pthread_sigmask(SIG_BLOCK, &stop_signals, &previous);
+        bool started = pthread_create(&thread, NULL, handle_connection, connection) == 0;
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (started)
+            pthread_detach(thread);
+        else
+            handle_connection(connection);
+    }
+
+    // Stop listening, let the requests in progress finish, then free the cache
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+        unlink(options->socket_path);
+    }
+    pthread_mutex_lock(&server.lock);
+    while (server.active > 0)
+    {
+        pthread_cond_wait(&server.idle, &server.lock);
+    }
+    pthread_mutex_unlock(&server.lock);
+    while (server.cache.oldest)
+    {
+        drop_entry(&server.cache, server.cache.oldest);
+    }
+    free(server.cache.buckets);
+    pthread_cond_destroy(&server.idle);
+    pthread_mutex_destroy(&server.lock);
+    pthread_mutex_destroy(&server.cache.lock);
+    return status;
+}
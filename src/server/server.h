@@ -0,0 +1,60 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "core/core.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SERVER_DEFAULT_MAX_PROGRAMS 128
+
+// Settings of a server started with `a++c --serve`
+typedef struct
+{
+    const char *socket_path; // The Unix domain socket to listen on
+    size_t max_programs;     // How many built programs are kept before the least recently used is dropped
+    const char *cache_dir;   // Passed on to build_program() (NULL disables the file cache)
+} ServerOptions;
+
+// What the server sent back for one request
+typedef struct
+{
+    int status;    // The exit status a++c would have returned for the script
+    char *output;  // Everything the script printed, compile errors included (not NUL-terminated)
+    size_t output_length;
+} ServerReply;
+
+/**
+ * @brief Serves run requests on a Unix domain socket until SIGINT or SIGTERM.
+ *
+ * Each request names a script by absolute path. Built programs are kept in
+ * an LRU cache keyed by the path and the optimization level; an entry is
+ * rebuilt when the file's modification time or size changes. Every
+ * connection is handled on its own thread, with the script's output
+ * (and compile errors) captured and sent back.
+ *
+ * @param options The server's settings.
+ * @return int The process exit status: 0 after a clean shutdown, 1 if the socket could not be set up.
+ */
+int run_server(const ServerOptions *options);
+
+/**
+ * @brief Asks a server to run a script and waits for the result.
+ *
+ * @param socket_path The server's socket.
+ * @param script_path The script to run; relative paths are resolved here, since the server has its own working directory.
+ * @param engine The engine to run it on.
+ * @param opt_level The optimization level (OPT_LEVEL_*).
+ * @param reply Receives the result on success; release it with free_server_reply().
+ * @return bool true if the server answered, false if it could not be reached (an error has been printed).
+ */
+bool request_run(const char *socket_path, const char *script_path, ExecutionEngine engine, int opt_level,
+                 ServerReply *reply);
+
+/**
+ * @brief Frees the output of a reply.
+ *
+ * @param reply The reply filled in by request_run().
+ */
+void free_server_reply(ServerReply *reply);
+
+#endif // SERVER_H
@@ -0,0 +1,203 @@
+#include "bytecode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Names used by the disassembler, indexed by OpCode
+static const char *opcode_names[OP_COUNT] = {
+    [OP_LOADK] = "LOADK",
+    [OP_MOVE] = "MOVE",
+    [OP_ADD] = "ADD",
+    [OP_SUB] = "SUB",
+    [OP_MUL] = "MUL",
+    [OP_DIV] = "DIV",
+    [OP_MOD] = "MOD",
+    [OP_POW] = "POW",
+    [OP_POWI] = "POWI",
+    [OP_PRINT_INT] = "PRINT_INT",
+    [OP_PRINT_BOOL] = "PRINT_BOOL",
+    [OP_PRINT_STRING] = "PRINT_STRING",
+    [OP_HALT] = "HALT",
+};
+
+// This function creates a new, empty chunk
+Chunk *create_chunk(void)
+{
+    Chunk *chunk = (Chunk *)calloc(1, sizeof(Chunk));
+    if (!chunk)
+    {
+        printf("Error: Failed to allocate memory for bytecode.\n");
+        exit(1);
+    }
+    return chunk;
+}
+
+// This function appends one instruction, growing the code array as needed
+size_t emit_instruction(Chunk *chunk, OpCode op, uint32_t a, uint32_t b, uint32_t c)
+{
+    if (chunk->code_count == chunk->code_capacity)
+    {
+        chunk->code_capacity = chunk->code_capacity ? chunk->code_capacity * 2 : 64;
+        chunk->code = realloc(chunk->code, chunk->code_capacity * sizeof(Instruction));
+        if (!chunk->code)
+        {
+            printf("Error: Failed to allocate memory for bytecode.\n");
+            exit(1);
+        }
+    }
+
+    Instruction *instruction = &chunk->code[chunk->code_count];
+    instruction->op = (uint8_t)op;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = c;
+    return chunk->code_count++;
+}
+
+// This function adds a value to the constant pool and returns its index
+uint32_t add_constant(Chunk *chunk, VariableType type, Value value)
+{
+    if (chunk->constant_count == chunk->constant_capacity)
+    {
+        chunk->constant_capacity = chunk->constant_capacity ? chunk->constant_capacity * 2 : 16;
+        chunk->constants = realloc(chunk->constants, chunk->constant_capacity * sizeof(Value));
+        chunk->constant_types = realloc(chunk->constant_types, chunk->constant_capacity * sizeof(VariableType));
+        if (!chunk->constants || !chunk->constant_types)
+        {
+            printf("Error: Failed to allocate memory for constants.\n");
+            exit(1);
+        }
+    }
+
+    // The chunk owns its string constants so it can outlive the AST
+    if (type == STRING_TYPE)
+    {
+        value.string_value = strdup(value.string_value);
+    }
+
+    chunk->constants[chunk->constant_count] = value;
+    chunk->constant_types[chunk->constant_count] = type;
+    return (uint32_t)chunk->constant_count++;
+}
+
+// This function replaces a constant, copying strings like add_constant()
+void set_constant(Chunk *chunk, uint32_t index, Value value)
+{
+    if (chunk->constant_types[index] == STRING_TYPE)
+    {
+        char *copy = strdup(value.string_value);
+        if (!copy)
+        {
+            printf("Error: Failed to allocate memory for constants.\n");
+            exit(1);
+        }
+        free((char *)chunk->constants[index].string_value);
+        value.string_value = copy;
+    }
+    chunk->constants[index] = value;
+}
+
+// This function records which constant a parameter's declaration loads
+void add_parameter(Chunk *chunk, uint32_t slot, uint32_t constant)
+{
+    if (chunk->parameter_count == chunk->parameter_capacity)
+    {
+        chunk->parameter_capacity = chunk->parameter_capacity ? chunk->parameter_capacity * 2 : 8;
+        chunk->parameters = realloc(chunk->parameters, chunk->parameter_capacity * sizeof(ChunkParameter));
+        if (!chunk->parameters)
+        {
+            printf("Error: Failed to allocate memory for bytecode.\n");
+            exit(1);
+        }
+    }
+    chunk->parameters[chunk->parameter_count].slot = slot;
+    chunk->parameters[chunk->parameter_count].constant = constant;
+    chunk->parameter_count++;
+}
+
+// This function prints one constant in a readable form
+static void print_constant(const Chunk *chunk, uint32_t index)
+{
+    Value value = chunk->constants[index];
+    switch (chunk->constant_types[index])
+    {
+    case INT_TYPE:
+        printf("%d", value.int_value);
+        break;
+    case BOOL_TYPE:
+        printf("%s", value.bool_value ? "true" : "false");
+        break;
+    case STRING_TYPE:
+        printf("\"%s\"", value.string_value);
+        break;
+    default:
+        printf("?");
+        break;
+    }
+}
+
+// This function prints a listing of the chunk's instructions
+void disassemble_chunk(const Chunk *chunk)
+{
+    printf("; %zu instructions, %zu constants, %u registers\n",
+           chunk->code_count, chunk->constant_count, chunk->register_count);
+
+    for (size_t i = 0; i < chunk->code_count; i++)
+    {
+        const Instruction *ins = &chunk->code[i];
+        printf("%04zu  %-12s ", i, opcode_names[ins->op]);
+
+        switch (ins->op)
+        {
+        case OP_LOADK:
+            printf("r%u, k%u  ; ", ins->a, ins->b);
+            print_constant(chunk, ins->b);
+            break;
+        case OP_MOVE:
+            printf("r%u, r%u", ins->a, ins->b);
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_MOD:
+        case OP_POW:
+            printf("r%u, r%u, r%u", ins->a, ins->b, ins->c);
+            break;
+        case OP_POWI:
+            printf("r%u, r%u, #%d", ins->a, ins->b, (int)ins->c);
+            break;
+        case OP_PRINT_INT:
+        case OP_PRINT_BOOL:
+        case OP_PRINT_STRING:
+            printf("r%u", ins->a);
+            break;
+        default:
+            break;
+        }
+        printf("\n");
+    }
+}
+
+// This function frees the chunk and everything it owns
+void free_chunk(Chunk *chunk)
+{
+    if (!chunk)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < chunk->constant_count; i++)
+    {
+        if (chunk->constant_types[i] == STRING_TYPE)
+        {
+            free((char *)chunk->constants[i].string_value);
+        }
+    }
+
+    free(chunk->code);
+    free(chunk->constants);
+    free(chunk->constant_types);
+    free(chunk->parameters);
+    free(chunk);
+}
@@ -0,0 +1,130 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "common/types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Opcodes understood by the register VM.
+// Operands are register indices (R) or constant pool indices (K).
+typedef enum
+{
+    OP_LOADK,        // R[a] = K[b]
+    OP_MOVE,         // R[a] = R[b]
+    OP_ADD,          // R[a] = R[b] + R[c]
+    OP_SUB,          // R[a] = R[b] - R[c]
+    OP_MUL,          // R[a] = R[b] * R[c]
+    OP_DIV,          // R[a] = R[b] / R[c]
+    OP_MOD,          // R[a] = R[b] % R[c]
+    OP_POW,          // R[a] = R[b] ** R[c]
+    OP_POWI,         // R[a] = R[b] ** c (c is a constant exponent stored in the instruction)
+    OP_PRINT_INT,    // print R[a] as an integer
+    OP_PRINT_BOOL,   // print R[a] as true/false
+    OP_PRINT_STRING, // print R[a] as a string
+    OP_HALT,         // stop execution
+    OP_COUNT
+} OpCode;
+
+// A single fixed-width instruction
+typedef struct
+{
+    uint8_t op;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+} Instruction;
+
+// A declaration without a value, whose starting value can be set per run (see set_constant())
+typedef struct
+{
+    uint32_t slot;     // The variable slot of the declaration
+    uint32_t constant; // The constant its register is loaded from
+} ChunkParameter;
+
+// A compiled program: flat instruction array, constant pool and register file size
+typedef struct
+{
+    Instruction *code;
+    size_t code_count;
+    size_t code_capacity;
+
+    Value *constants;
+    VariableType *constant_types;
+    size_t constant_count;
+    size_t constant_capacity;
+
+    ChunkParameter *parameters;
+    size_t parameter_count;
+    size_t parameter_capacity;
+
+    uint32_t register_count;
+} Chunk;
+
+/**
+ * @brief Creates a new, empty bytecode chunk.
+ *
+ * @return Chunk* A pointer to the newly created Chunk.
+ */
+Chunk *create_chunk(void);
+
+/**
+ * @brief Appends an instruction to the chunk.
+ *
+ * @param chunk A pointer to the Chunk.
+ * @param op The opcode.
+ * @param a The first operand.
+ * @param b The second operand.
+ * @param c The third operand.
+ * @return size_t The index of the emitted instruction.
+ */
+size_t emit_instruction(Chunk *chunk, OpCode op, uint32_t a, uint32_t b, uint32_t c);
+
+/**
+ * @brief Adds a constant to the chunk's constant pool.
+ *
+ * String constants are copied and owned by the chunk.
+ *
+ * @param chunk A pointer to the Chunk.
+ * @param type The type of the constant.
+ * @param value The value of the constant.
+ * @return uint32_t The index of the constant in the pool.
+ */
+uint32_t add_constant(Chunk *chunk, VariableType type, Value value);
+
+/**
+ * @brief Replaces a constant in the pool, keeping its type.
+ *
+ * Used to give a parameter its value for the following runs. String
+ * constants are copied and owned by the chunk.
+ *
+ * @param chunk A pointer to the Chunk.
+ * @param index The index of the constant.
+ * @param value The new value.
+ */
+void set_constant(Chunk *chunk, uint32_t index, Value value);
+
+/**
+ * @brief Records that a declaration without a value loads its variable from a constant.
+ *
+ * @param chunk A pointer to the Chunk.
+ * @param slot The variable slot of the declaration.
+ * @param constant The index of the constant it is loaded from.
+ */
+void add_parameter(Chunk *chunk, uint32_t slot, uint32_t constant);
+
+/**
+ * @brief Prints a human-readable listing of the chunk to stdout.
+ *
+ * @param chunk A pointer to the Chunk.
+ */
+void disassemble_chunk(const Chunk *chunk);
+
+/**
+ * @brief Frees the memory allocated for a chunk, including its constants.
+ *
+ * @param chunk A pointer to the Chunk to be freed.
+ */
+void free_chunk(Chunk *chunk);
+
+#endif // BYTECODE_H
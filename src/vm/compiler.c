@@ -0,0 +1,210 @@
+#include "compiler.h"
+#include "common/report.h"
+#include "common/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_TARGET UINT32_MAX
+
+// State carried through one compilation
+typedef struct
+{
+    Chunk *chunk;
+    uint32_t slot_count;      // Registers [0, slot_count) hold the variables
+    uint32_t next_register;   // First register free for temporaries
+    bool had_error;
+} Compiler;
+
+// This function reserves a register, growing the chunk's register file
+static uint32_t allocate_register(Compiler *compiler)
+{
+    uint32_t reg = compiler->next_register++;
+    if (compiler->next_register > compiler->chunk->register_count)
+    {
+        compiler->chunk->register_count = compiler->next_register;
+    }
+    return reg;
+}
+
+// Opcodes implementing each binary operator, indexed by BinaryOperator
+static const OpCode binary_opcodes[BINOP_COUNT] = {
+    [BINOP_ADD] = OP_ADD,
+    [BINOP_SUB] = OP_SUB,
+    [BINOP_MUL] = OP_MUL,
+    [BINOP_DIV] = OP_DIV,
+    [BINOP_MOD] = OP_MOD,
+    [BINOP_POW] = OP_POW,
+};
+
+// This function loads a constant into 'target' (or a fresh temporary)
+static uint32_t emit_constant(Compiler *compiler, VariableType type, Value value, uint32_t target)
+{
+    uint32_t dst = target != NO_TARGET ? target : allocate_register(compiler);
+    uint32_t k = add_constant(compiler->chunk, type, value);
+    emit_instruction(compiler->chunk, OP_LOADK, dst, k, 0);
+    return dst;
+}
+
+// This function compiles an expression and returns the register holding its value.
+// If 'target' is given the result is guaranteed to end up in that register.
+static uint32_t compile_expression(Compiler *compiler, ASTNode *node, uint32_t target)
+{
+    Value value;
+
+    switch (node->type)
+    {
+    case NODE_INT_LITERAL:
+        value.int_value = node->int_value;
+        return emit_constant(compiler, INT_TYPE, value, target);
+
+    case NODE_BOOL_LITERAL:
+        value.bool_value = node->bool_value;
+        return emit_constant(compiler, BOOL_TYPE, value, target);
+
+    case NODE_STRING_LITERAL:
+        value.string_value = node->value;
+        return emit_constant(compiler, STRING_TYPE, value, target);
+
+    case NODE_LITERAL:
+    {
+        // Variables live in the register numbered after their slot
+        uint32_t reg = (uint32_t)node->slot;
+        if (target != NO_TARGET && target != reg)
+        {
+            emit_instruction(compiler->chunk, OP_MOVE, target, reg, 0);
+            return target;
+        }
+        // Reading a variable needs no instruction: its register is used directly
+        return reg;
+    }
+
+    case NODE_BINARY_OP:
+    {
+        if ((unsigned)node->op >= BINOP_COUNT)
+        {
+            report("Error: Unknown binary operator %d.\n", node->op);
+            compiler->had_error = true;
+            return target != NO_TARGET ? target : allocate_register(compiler);
+        }
+        OpCode opcode = binary_opcodes[node->op];
+        uint32_t left;
+
+        // A constant exponent is encoded in the instruction instead of being loaded into a register
+        if (node->op == BINOP_POW && node->right->type == NODE_INT_LITERAL)
+        {
+            left = compile_expression(compiler, node->left, NO_TARGET);
+            uint32_t dst = target != NO_TARGET ? target : allocate_register(compiler);
+            emit_instruction(compiler->chunk, OP_POWI, dst, left, (uint32_t)node->right->int_value);
+            return dst;
+        }
+
+        left = compile_expression(compiler, node->left, NO_TARGET);
+        uint32_t right = compile_expression(compiler, node->right, NO_TARGET);
+
+        // Operands are read before the result is written, so the target may alias them
+        uint32_t dst = target != NO_TARGET ? target : allocate_register(compiler);
+        emit_instruction(compiler->chunk, opcode, dst, left, right);
+        return dst;
+    }
+
+    default:
+        report("Error: Unsupported expression node type %d.\n", node->type);
+        compiler->had_error = true;
+        return target != NO_TARGET ? target : allocate_register(compiler);
+    }
+}
+
+// This function compiles a variable declaration into a fresh register
+static void compile_var_declaration(Compiler *compiler, ASTNode *node)
+{
+    uint32_t reg = (uint32_t)node->slot;
+    if (node->left)
+    {
+        compile_expression(compiler, node->left, reg);
+    }
+    else
+    {
+        // Variables without an initializer start out as 0, false or "". They
+        // get a constant of their own, so a parameter value can replace it.
+        Value zero;
+        memset(&zero, 0, sizeof(zero));
+        if (node->value_type == STRING_TYPE)
+        {
+            zero.string_value = "";
+        }
+        uint32_t k = add_constant(compiler->chunk, node->value_type, zero);
+        emit_instruction(compiler->chunk, OP_LOADK, reg, k, 0);
+        add_parameter(compiler->chunk, reg, k);
+    }
+}
+
+// This function compiles an assignment to an existing variable
+static void compile_assignment(Compiler *compiler, ASTNode *node)
+{
+    compile_expression(compiler, node->left, (uint32_t)node->slot);
+}
+
+// This function compiles a print statement into the print opcode for the value's type
+static void compile_print(Compiler *compiler, ASTNode *node)
+{
+    uint32_t reg = compile_expression(compiler, node->left, NO_TARGET);
+
+    switch (node->left->value_type)
+    {
+    case BOOL_TYPE:
+        emit_instruction(compiler->chunk, OP_PRINT_BOOL, reg, 0, 0);
+        break;
+    case STRING_TYPE:
+        emit_instruction(compiler->chunk, OP_PRINT_STRING, reg, 0, 0);
+        break;
+    default:
+        emit_instruction(compiler->chunk, OP_PRINT_INT, reg, 0, 0);
+        break;
+    }
+}
+
+// This function lowers the whole statement list into a chunk
+Chunk *compile_to_bytecode(ASTNode *node, size_t slot_count)
+{
+    Compiler compiler;
+    memset(&compiler, 0, sizeof(compiler));
+    compiler.chunk = create_chunk();
+    compiler.slot_count = (uint32_t)slot_count;
+    compiler.chunk->register_count = compiler.slot_count;
+
+    for (; node != NULL; node = node->next)
+    {
+        // Temporaries live above the variables and only for the duration of a statement
+        compiler.next_register = compiler.slot_count;
+
+        switch (node->type)
+        {
+        case NODE_VAR_DECLARATION:
+            compile_var_declaration(&compiler, node);
+            break;
+        case NODE_ASSIGNMENT:
+            compile_assignment(&compiler, node);
+            break;
+        case NODE_PRINT:
+            compile_print(&compiler, node);
+            break;
+        default:
+            report("Error: Unknown node type in compiler: %d\n", node->type);
+            compiler.had_error = true;
+            break;
+        }
+    }
+
+    emit_instruction(compiler.chunk, OP_HALT, 0, 0, 0);
+
+    if (compiler.had_error)
+    {
+        free_chunk(compiler.chunk);
+        return NULL;
+    }
+
+    TRACE_INFO(TRACE_VM, "Compiled %zu instructions, %zu constants, %u registers",
+               compiler.chunk->code_count, compiler.chunk->constant_count, compiler.chunk->register_count);
+    return compiler.chunk;
+}
@@ -0,0 +1,22 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "ast/ast.h"
+#include "vm/bytecode.h"
+#include <stddef.h>
+
+/**
+ * @brief Lowers an AST into a bytecode chunk for the register VM.
+ *
+ * The AST must already have been resolved and type-checked: register N
+ * holds the variable in slot N, expression temporaries are allocated above
+ * the variables and released at the end of each statement, and constants
+ * and print opcodes are chosen from the type checker's annotations.
+ *
+ * @param node The root node of the AST (the first statement in the list).
+ * @param slot_count The number of variable slots assigned by the resolver.
+ * @return Chunk* The compiled chunk, or NULL if compilation failed.
+ */
+Chunk *compile_to_bytecode(ASTNode *node, size_t slot_count);
+
+#endif // COMPILER_H
@@ -0,0 +1,160 @@
+#include "vm.h"
+#include "common/intmath.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Use computed gotos where the compiler supports them; each handler then
+// jumps straight to the next one instead of going back through a switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+// This function runs the chunk until it reaches OP_HALT
+int run_bytecode(const Chunk *chunk, Output *out)
+{
+    Value *registers = (Value *)calloc(chunk->register_count ? chunk->register_count : 1, sizeof(Value));
+    if (!registers)
+    {
+        printf("Error: Failed to allocate memory for VM registers.\n");
+        return 1;
+    }
+
+    const Instruction *ip = chunk->code;
+    const Value *constants = chunk->constants;
+    Value *R = registers;
+
+#if VM_COMPUTED_GOTO
+    static void *dispatch_table[OP_COUNT] = {
+        [OP_LOADK] = &&do_LOADK,
+        [OP_MOVE] = &&do_MOVE,
+        [OP_ADD] = &&do_ADD,
+        [OP_SUB] = &&do_SUB,
+        [OP_MUL] = &&do_MUL,
+        [OP_DIV] = &&do_DIV,
+        [OP_MOD] = &&do_MOD,
+        [OP_POW] = &&do_POW,
+        [OP_POWI] = &&do_POWI,
+        [OP_PRINT_INT] = &&do_PRINT_INT,
+        [OP_PRINT_BOOL] = &&do_PRINT_BOOL,
+        [OP_PRINT_STRING] = &&do_PRINT_STRING,
+        [OP_HALT] = &&do_HALT,
+    };
+#define DISPATCH() goto *dispatch_table[ip->op]
+#define CASE(name) do_##name:
+#define NEXT() \
+    do        \
+    {         \
+        ip++; \
+        DISPATCH(); \
+    } while (0)
+    DISPATCH();
+#else
+#define CASE(name) case OP_##name:
+#define NEXT() \
+    ip++;      \
+    break
+    for (;;)
+    {
+        switch ((OpCode)ip->op)
+        {
+#endif
+
+    CASE(LOADK)
+        R[ip->a] = constants[ip->b];
+        NEXT();
+
+    CASE(MOVE)
+        R[ip->a] = R[ip->b];
+        NEXT();
+
+    CASE(ADD)
+        R[ip->a].int_value = int_add(R[ip->b].int_value, R[ip->c].int_value);
+        NEXT();
+
+    CASE(SUB)
+        R[ip->a].int_value = int_sub(R[ip->b].int_value, R[ip->c].int_value);
+        NEXT();
+
+    CASE(MUL)
+        R[ip->a].int_value = int_mul(R[ip->b].int_value, R[ip->c].int_value);
+        NEXT();
+
+    CASE(DIV)
+        if (R[ip->c].int_value == 0)
+        {
+            output_string(out, "Error: Division by zero");
+            output_newline(out);
+            R[ip->a].int_value = 0;
+        }
+        else
+        {
+            R[ip->a].int_value = int_div(R[ip->b].int_value, R[ip->c].int_value);
+        }
+        NEXT();
+
+    CASE(MOD)
+        if (R[ip->c].int_value == 0)
+        {
+            output_string(out, "Error: Modulus by zero");
+            output_newline(out);
+            R[ip->a].int_value = 0;
+        }
+        else
+        {
+            R[ip->a].int_value = int_mod(R[ip->b].int_value, R[ip->c].int_value);
+        }
+        NEXT();
+
+    CASE(POW)
+        if (!int_pow(R[ip->b].int_value, R[ip->c].int_value, &R[ip->a].int_value))
+        {
+            output_string(out, "Error: Integer overflow in '**'");
+            output_newline(out);
+            R[ip->a].int_value = 0;
+        }
+        NEXT();
+
+    CASE(POWI)
+        // The exponent is an immediate, so small powers go straight to int_pow's direct path
+        if (!int_pow(R[ip->b].int_value, (int)ip->c, &R[ip->a].int_value))
+        {
+            output_string(out, "Error: Integer overflow in '**'");
+            output_newline(out);
+            R[ip->a].int_value = 0;
+        }
+        NEXT();
+
+    CASE(PRINT_INT)
+        output_int(out, R[ip->a].int_value);
+        output_newline(out);
+        NEXT();
+
+    CASE(PRINT_BOOL)
+        output_bool(out, R[ip->a].bool_value);
+        output_newline(out);
+        NEXT();
+
+    CASE(PRINT_STRING)
+        output_string(out, R[ip->a].string_value);
+        output_newline(out);
+        NEXT();
+
+    CASE(HALT)
+        free(registers);
+        return 0;
+
+#if !VM_COMPUTED_GOTO
+        default:
+            printf("Error: Unknown opcode %d\n", ip->op);
+            free(registers);
+            return 1;
+        }
+    }
+#endif
+
+#undef CASE
+#undef NEXT
+#undef DISPATCH
+}
@@ -0,0 +1,16 @@
+#ifndef VM_H
+#define VM_H
+
+#include "vm/bytecode.h"
+#include "runtime/output.h"
+
+/**
+ * @brief Executes a compiled bytecode chunk on the register VM.
+ *
+ * @param chunk A pointer to the Chunk to execute.
+ * @param out The writer that receives the program's output.
+ * @return int 0 on success, non-zero if execution could not start.
+ */
+int run_bytecode(const Chunk *chunk, Output *out);
+
+#endif // VM_H